@@ -67,6 +67,18 @@ static struct timeval last_wakeup;
 /** current limit for the main loop's runtime */
 static float main_loop_iteration_limit = 0.1;
 
+/** Frame rate used for frame pacing when the monitors' one is unknown */
+#define DEFAULT_REFRESH_RATE 60
+
+/** time of the last frame-paced refresh, in microseconds */
+static gint64 last_frame;
+
+/** did something happen since the last frame-paced refresh? */
+static bool frame_pending = true;
+
+/** current limit for a frame's deferred work, as a fraction of a frame */
+static float frame_work_limit = 1;
+
 /** Call before exiting.
  */
 void
@@ -356,6 +368,46 @@ a_xcb_io_cb(GIOChannel *source, GIOCondition cond, gpointer data)
     return TRUE;
 }
 
+/** Do the deferred work if a frame is due, else shorten the poll timeout
+ * to wake up for the next frame.
+ * \param timeout The poll timeout in milliseconds, updated.
+ */
+static void
+a_frame_refresh(gint *timeout)
+{
+    double rate = globalconf.refresh_rate > 0 ? globalconf.refresh_rate : DEFAULT_REFRESH_RATE;
+    gint64 interval = G_USEC_PER_SEC / rate;
+    gint64 now = g_get_monotonic_time();
+    gint64 elapsed;
+    float work;
+
+    if(!frame_pending)
+        return;
+
+    if(now - last_frame < interval)
+    {
+        gint wait = (interval - (now - last_frame) + 999) / 1000;
+        if(*timeout < 0 || wait < *timeout)
+            *timeout = wait;
+        return;
+    }
+
+    /* Stay in phase with the previous frames unless we fell behind */
+    last_frame = now - last_frame < 2 * interval ? last_frame + interval : now;
+    frame_pending = false;
+    awesome_refresh();
+
+    /* Check how much of the frame the deferred work used up */
+    elapsed = g_get_monotonic_time() - now;
+    work = (float) elapsed / interval;
+    if(work > frame_work_limit)
+    {
+        warn("Deferred work took %.6f seconds, %.0f%% of a frame! Increasing "
+                "limit for this warning to that value.", elapsed / 1e6, work * 100);
+        frame_work_limit = work;
+    }
+}
+
 static gint
 a_glib_poll(GPollFD *ufds, guint nfsd, gint timeout)
 {
@@ -364,8 +416,11 @@ a_glib_poll(GPollFD *ufds, guint nfsd, gint timeout)
     float length;
     lua_State *L = globalconf_get_lua_State();
 
-    /* Do all deferred work now */
-    awesome_refresh();
+    /* Do all deferred work now, or at the next frame */
+    if(globalconf.frame_pacing)
+        a_frame_refresh(&timeout);
+    else
+        awesome_refresh();
 
     /* Check if the Lua stack is the way it should be */
     if (lua_gettop(L) != 0) {
@@ -395,6 +450,9 @@ a_glib_poll(GPollFD *ufds, guint nfsd, gint timeout)
     gettimeofday(&last_wakeup, NULL);
     a_xcb_check();
 
+    /* Whatever woke us up may have queued deferred work */
+    frame_pending = true;
+
     return res;
 }
 
@@ -44,6 +44,29 @@
 #include <xcb/xcb_event.h>
 #include <xcb/xkb.h>
 
+/** Emit a signal on the matching bindings which were pushed on the stack and
+ * pop them and the signal arguments.
+ * \param L The Lua VM state.
+ * \param signame The signal to emit, or NULL to only pop the bindings.
+ * \param item_matching The number of bindings on top of the stack.
+ * \param nargs The number of signal arguments, just below the bindings.
+ */
+static void
+event_emit_bindings(lua_State *L, const char *signame, int item_matching, int nargs)
+{
+    for(; item_matching > 0; item_matching--)
+    {
+        if(signame)
+        {
+            for(int i = 0; i < nargs; i++)
+                lua_pushvalue(L, - nargs - item_matching);
+            luaA_object_emit_signal(L, - nargs - 1, signame, nargs);
+        }
+        lua_pop(L, 1);
+    }
+    lua_pop(L, nargs);
+}
+
 #define DO_EVENT_HOOK_CALLBACK(type, xcbtype, xcbeventprefix, arraytype, match) \
     static void \
     event_##xcbtype##_callback(xcb_##xcbtype##_press_event_t *ev, \
@@ -64,36 +87,20 @@
                     luaA_object_push(L, *item); \
                 item_matching++; \
             } \
-        for(; item_matching > 0; item_matching--) \
+        switch(ev->response_type) \
         { \
-            switch(ev->response_type) \
-            { \
-              case xcbeventprefix##_PRESS: \
-                for(int i = 0; i < nargs; i++) \
-                    lua_pushvalue(L, - nargs - item_matching); \
-                luaA_object_emit_signal(L, - nargs - 1, "press", nargs); \
-                break; \
-              case xcbeventprefix##_RELEASE: \
-                for(int i = 0; i < nargs; i++) \
-                    lua_pushvalue(L, - nargs - item_matching); \
-                luaA_object_emit_signal(L, - nargs - 1, "release", nargs); \
-                break; \
-            } \
-            lua_pop(L, 1); \
+          case xcbeventprefix##_PRESS: \
+            event_emit_bindings(L, "press", item_matching, nargs); \
+            break; \
+          case xcbeventprefix##_RELEASE: \
+            event_emit_bindings(L, "release", item_matching, nargs); \
+            break; \
+          default: \
+            event_emit_bindings(L, NULL, item_matching, nargs); \
+            break; \
         } \
-        lua_pop(L, nargs); \
     }
 
-static bool
-event_key_match(xcb_key_press_event_t *ev, keyb_t *k, void *data)
-{
-    assert(data);
-    xcb_keysym_t keysym = *(xcb_keysym_t *) data;
-    return (((k->keycode && ev->detail == k->keycode)
-             || (k->keysym && keysym == k->keysym))
-            && (k->modifiers == XCB_BUTTON_MASK_ANY || k->modifiers == ev->state));
-}
-
 static bool
 event_button_match(xcb_button_press_event_t *ev, button_t *b, void *data)
 {
@@ -102,7 +109,36 @@ event_button_match(xcb_button_press_event_t *ev, button_t *b, void *data)
 }
 
 DO_EVENT_HOOK_CALLBACK(button_t, button, XCB_BUTTON, button_array_t, event_button_match)
-DO_EVENT_HOOK_CALLBACK(keyb_t, key, XCB_KEY, key_array_t, event_key_match)
+
+/** Emit the press or release signal on the key bindings matching an event.
+ * Candidates are found through the index of the key set instead of testing
+ * every binding.
+ * \param ev The key event.
+ * \param keys The key bindings.
+ * \param L The Lua VM state.
+ * \param nargs The number of arguments on the stack to pass to the signal.
+ * \param keysym The keysym of the event, ignoring modifiers.
+ */
+static void
+event_key_callback(xcb_key_press_event_t *ev, key_set_t *keys,
+                   lua_State *L, int nargs, xcb_keysym_t keysym)
+{
+    /* Only used during a dispatch, kept around to avoid reallocations */
+    static key_array_t matches;
+    const char *signame = NULL;
+
+    matches.len = 0;
+    key_set_lookup(keys, ev->detail, keysym, ev->state, &matches);
+
+    foreach(item, matches)
+        luaA_object_push(L, *item);
+
+    if(ev->response_type == XCB_KEY_PRESS)
+        signame = "press";
+    else if(ev->response_type == XCB_KEY_RELEASE)
+        signame = "release";
+    event_emit_bindings(L, signame, matches.len, nargs);
+}
 
 /** Handle an event with mouse grabber if needed
  * \param x The x coordinate.
@@ -113,6 +149,8 @@ DO_EVENT_HOOK_CALLBACK(keyb_t, key, XCB_KEY, key_array_t, event_key_match)
 static bool
 event_handle_mousegrabber(int x, int y, uint16_t mask)
 {
+    if(mousegrabber_moveresize_handleevent(x, y, mask))
+        return true;
     if(globalconf.mousegrabber != LUA_REFNIL)
     {
         lua_State *L = globalconf_get_lua_State();
@@ -396,6 +434,8 @@ event_handle_configurerequest(xcb_configure_request_event_t *ev)
         }
 
         c->got_configure_request = true;
+        /* Reply to the request even if it doesn't change anything */
+        client_need_geometry_refresh(c);
         client_resize(c, geometry, false);
     }
     else if (xembed_getbywin(&globalconf.embedded, ev->window))
@@ -720,10 +760,10 @@ event_handle_key(xcb_key_press_event_t *ev)
         if((c = client_getbywin(ev->event)) || (c = client_getbynofocuswin(ev->event)))
         {
             luaA_object_push(L, c);
-            event_key_callback(ev, &c->keys, L, -1, 1, &keysym);
+            event_key_callback(ev, c->keys, L, 1, keysym);
         }
         else
-            event_key_callback(ev, &globalconf.keys, L, 0, 0, &keysym);
+            event_key_callback(ev, globalconf.keys, L, 0, keysym);
     }
 }
 
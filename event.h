@@ -23,6 +23,7 @@
 #define AWESOME_EVENT_H
 
 #include "banning.h"
+#include "ewmh.h"
 #include "globalconf.h"
 #include "stack.h"
 
@@ -41,16 +42,23 @@ void client_destroy_later(void);
 
 /* objects/screen.c */
 void screen_refresh(void);
+void screen_refresh_workarea(void);
+
+/* xkb.c */
+void xkb_refresh(void);
 
 static inline int
 awesome_refresh(void)
 {
     screen_refresh();
     luaA_emit_refresh();
+    screen_refresh_workarea();
     drawin_refresh();
     client_refresh();
+    xkb_refresh();
     banning_refresh();
     stack_refresh();
+    ewmh_refresh();
     client_destroy_later();
     return xcb_flush(globalconf.connection);
 }
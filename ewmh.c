@@ -21,6 +21,7 @@
 
 #include "ewmh.h"
 #include "objects/client.h"
+#include "objects/screen.h"
 #include "objects/tag.h"
 #include "common/atoms.h"
 #include "xwindow.h"
@@ -35,6 +36,61 @@
 #define _NET_WM_STATE_ADD 1
 #define _NET_WM_STATE_TOGGLE 2
 
+/** A list of client windows published on the root window. Changes are
+ * collected and written once by ewmh_refresh(), and only if the list differs
+ * from what was written last time.
+ */
+typedef struct
+{
+    /** Does the property have to be recomputed? */
+    bool need_update;
+    /** Was the property written at least once? */
+    bool written;
+    /** The windows last written, and the allocated size of the buffer */
+    xcb_window_t *windows;
+    int len, size;
+} ewmh_window_list_t;
+
+static ewmh_window_list_t net_client_list;
+static ewmh_window_list_t net_client_list_stacking;
+
+/** Write a window list property if its content changed.
+ * \param list The window list.
+ * \param atom The property to write.
+ * \param clients The clients in the order in which they should appear.
+ */
+static void
+ewmh_window_list_refresh(ewmh_window_list_t *list, xcb_atom_t atom, client_array_t *clients)
+{
+    if(!list->need_update)
+        return;
+    list->need_update = false;
+
+    if(clients->len > list->size)
+    {
+        list->size = clients->len;
+        p_realloc(&list->windows, list->size);
+    }
+
+    bool changed = !list->written || list->len != clients->len;
+    int n = 0;
+    foreach(client, *clients)
+    {
+        xcb_window_t window = (*client)->window;
+        changed = changed || list->windows[n] != window;
+        list->windows[n++] = window;
+    }
+    list->len = n;
+
+    if(!changed)
+        return;
+
+    list->written = true;
+    xcb_change_property(globalconf.connection, XCB_PROP_MODE_REPLACE,
+                        globalconf.screen->root,
+                        atom, XCB_ATOM_WINDOW, 32, n, list->windows);
+}
+
 /** Update client EWMH hints.
  * \param L The Lua VM state.
  */
@@ -92,16 +148,7 @@ ewmh_update_net_active_window(lua_State *L)
 static int
 ewmh_update_net_client_list(lua_State *L)
 {
-    xcb_window_t *wins = p_alloca(xcb_window_t, globalconf.clients.len);
-
-    int n = 0;
-    foreach(client, globalconf.clients)
-        wins[n++] = (*client)->window;
-
-    xcb_change_property(globalconf.connection, XCB_PROP_MODE_REPLACE,
-                        globalconf.screen->root,
-                        _NET_CLIENT_LIST, XCB_ATOM_WINDOW, 32, n, wins);
-
+    net_client_list.need_update = true;
     return 0;
 }
 
@@ -162,6 +209,7 @@ ewmh_init(void)
         _NET_WM_WINDOW_TYPE_NORMAL,
         _NET_WM_ICON,
         _NET_WM_PID,
+        _NET_WM_PING,
         _NET_WM_STATE,
         _NET_WM_STATE_STICKY,
         _NET_WM_STATE_SKIP_TASKBAR,
@@ -246,15 +294,15 @@ ewmh_init_lua(void)
 void
 ewmh_update_net_client_list_stacking(void)
 {
-    int n = 0;
-    xcb_window_t *wins = p_alloca(xcb_window_t, globalconf.stack.len);
-
-    foreach(client, globalconf.stack)
-        wins[n++] = (*client)->window;
+    net_client_list_stacking.need_update = true;
+}
 
-    xcb_change_property(globalconf.connection, XCB_PROP_MODE_REPLACE,
-			globalconf.screen->root,
-			_NET_CLIENT_LIST_STACKING, XCB_ATOM_WINDOW, 32, n, wins);
+/** Write the client lists that changed since the last main loop iteration. */
+void
+ewmh_refresh(void)
+{
+    ewmh_window_list_refresh(&net_client_list, _NET_CLIENT_LIST, &globalconf.clients);
+    ewmh_window_list_refresh(&net_client_list_stacking, _NET_CLIENT_LIST_STACKING, &globalconf.stack);
 }
 
 void
@@ -445,7 +493,14 @@ ewmh_process_client_message(xcb_client_message_event_t *ev)
     else if(ev->type == _NET_CLOSE_WINDOW)
     {
         if((c = client_getbywin(ev->window)))
-           client_kill(c);
+           client_kill(c, 0);
+    }
+    else if(ev->type == WM_PROTOCOLS && ev->data.data32[0] == _NET_WM_PING)
+    {
+        /* Clients answer a ping by sending it back to the root window */
+        if(ev->window == globalconf.screen->root
+           && (c = client_getbywin(ev->data.data32[2])))
+            client_ping_reply(c, ev->data.data32[1]);
     }
     else if(ev->type == _NET_WM_DESKTOP)
     {
@@ -654,6 +709,8 @@ ewmh_process_client_strut(client_t *c)
             c->strut.bottom_start_x = strut[10];
             c->strut.bottom_end_x = strut[11];
 
+            screen_strut_client_update(c);
+
             lua_State *L = globalconf_get_lua_State();
             luaA_object_push(L, c);
             luaA_object_emit_signal(L, -1, "property::struts", 0);
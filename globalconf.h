@@ -89,7 +89,7 @@ typedef struct
     /** The primary screen, access through screen_get_primary() */
     screen_t *primary_screen;
     /** Root window key bindings */
-    key_array_t keys;
+    key_set_t *keys;
     /** Root window mouse bindings */
     button_array_t buttons;
     /** Atom for WM_Sn */
@@ -102,6 +102,12 @@ typedef struct
     bool have_randr_15;
     /** Do we have a RandR screen update pending? */
     bool screen_need_refresh;
+    /** RandR timestamps of the last scanned screen configuration */
+    xcb_timestamp_t randr_timestamp, randr_config_timestamp;
+    /** Refresh rate of the fastest monitor in Hz, 0 if unknown */
+    double refresh_rate;
+    /** Do we limit the deferred work to one pass per frame? */
+    bool frame_pacing;
     /** Check for XTest extension */
     bool have_xtest;
     /** Check for SHAPE extension */
@@ -145,6 +151,15 @@ typedef struct
     } focus;
     /** Drawins */
     drawin_array_t drawins;
+    /** Nesting depth of client.batch() calls */
+    int client_batch_depth;
+    /** Clients whose geometry signals are deferred until the batch ends */
+    client_array_t batch_clients;
+    /** Clients whose X11 geometry has to be updated in the next refresh */
+    client_array_t geometry_dirty_clients;
+    /** Clients and drawins with a non-empty strut */
+    client_array_t strut_clients;
+    drawin_array_t strut_drawins;
     /** The startup notification display struct */
     SnDisplay *sndisplay;
     /** Latest timestamp we got from the X server */
@@ -178,6 +193,8 @@ typedef struct
     xcb_colormap_t default_cmap;
     /** Do we have to reban clients? */
     bool need_lazy_banning;
+    /** Do we have to regrab keys after a keymap change? */
+    bool need_key_regrab;
     /** Tag list */
     tag_array_t tags;
     /** List of registered xproperties */
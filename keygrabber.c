@@ -25,37 +25,146 @@
  * @module keygrabber
  */
 
-#include <unistd.h>
+#include <glib.h>
 #include <xkbcommon/xkbcommon.h>
 #include <xkbcommon/xkbcommon-x11.h>
 
 #include "keygrabber.h"
 #include "globalconf.h"
+#include "luaa.h"
 
-/** Grab the keyboard.
- * \return True if keyboard was grabbed.
+/** Interval between two keyboard grab attempts, in milliseconds */
+#define KEYGRABBER_GRAB_INTERVAL 1
+/** How long to try grabbing the keyboard before giving up, in microseconds */
+#define KEYGRABBER_GRAB_TIMEOUT G_USEC_PER_SEC
+
+/** State of the keyboard grab acquisition */
+static struct
+{
+    /** The retry timeout source, 0 when not acquiring the grab */
+    guint source;
+    /** Is a GrabKeyboard request waiting for its reply? */
+    bool pending;
+    /** Sequence number of the pending request */
+    unsigned int sequence;
+    /** Monotonic time after which we give up */
+    gint64 deadline;
+} keygrabber_grab_state;
+
+/** Send a keyboard grab request without waiting for the reply.
  */
-static bool
-keygrabber_grab(void)
+static void
+keygrabber_grab_send(void)
 {
-    int i;
-    xcb_grab_keyboard_reply_t *xgb;
+    xcb_grab_keyboard_cookie_t cookie =
+        xcb_grab_keyboard(globalconf.connection, true,
+                          globalconf.screen->root,
+                          XCB_CURRENT_TIME, XCB_GRAB_MODE_ASYNC,
+                          XCB_GRAB_MODE_ASYNC);
+    keygrabber_grab_state.sequence = cookie.sequence;
+    keygrabber_grab_state.pending = true;
+    xcb_flush(globalconf.connection);
+}
 
-    for(i = 1000; i; i--)
+/** Stop trying to acquire the keyboard grab.
+ */
+static void
+keygrabber_grab_cancel(void)
+{
+    if(keygrabber_grab_state.source)
     {
-        if((xgb = xcb_grab_keyboard_reply(globalconf.connection,
-                                          xcb_grab_keyboard(globalconf.connection, true,
-                                                            globalconf.screen->root,
-                                                            XCB_CURRENT_TIME, XCB_GRAB_MODE_ASYNC,
-                                                            XCB_GRAB_MODE_ASYNC),
-                                          NULL)))
+        g_source_remove(keygrabber_grab_state.source);
+        keygrabber_grab_state.source = 0;
+    }
+    if(keygrabber_grab_state.pending)
+    {
+        xcb_discard_reply(globalconf.connection, keygrabber_grab_state.sequence);
+        keygrabber_grab_state.pending = false;
+    }
+}
+
+/** Tell Lua about the outcome of the grab.
+ * This emits the "keygrabber::grab_acquired" or "keygrabber::grab_failed"
+ * global signal. The keygrabber is stopped before a failure is reported.
+ * \param acquired True if the keyboard was grabbed.
+ */
+static void
+keygrabber_grab_notify(bool acquired)
+{
+    lua_State *L = globalconf_get_lua_State();
+
+    if(acquired)
+    {
+        signal_object_emit(L, &global_signals, "keygrabber::grab_acquired", 0);
+        return;
+    }
+
+    warn("Unable to grab the keyboard, stopping keygrabber.");
+    luaA_keygrabber_stop(L);
+    signal_object_emit(L, &global_signals, "keygrabber::grab_failed", 0);
+}
+
+/** Check on the keyboard grab, retrying until it succeeds or times out.
+ * This runs from the main loop, so waiting for another client to release its
+ * grab doesn't block anything else.
+ * \param data Unused.
+ * \return Whether to keep the retry timeout around.
+ */
+static gboolean
+keygrabber_grab_check(gpointer data)
+{
+    if(keygrabber_grab_state.pending)
+    {
+        xcb_grab_keyboard_reply_t *reply = NULL;
+        xcb_generic_error_t *error = NULL;
+
+        if(!xcb_poll_for_reply(globalconf.connection, keygrabber_grab_state.sequence,
+                               (void **) &reply, &error))
+        {
+            /* No reply yet */
+            if(g_get_monotonic_time() < keygrabber_grab_state.deadline)
+                return G_SOURCE_CONTINUE;
+            keygrabber_grab_state.source = 0;
+            keygrabber_grab_cancel();
+            /* It might still succeed, but we no longer want it */
+            xcb_ungrab_keyboard(globalconf.connection, XCB_CURRENT_TIME);
+            keygrabber_grab_notify(false);
+            return G_SOURCE_REMOVE;
+        }
+
+        keygrabber_grab_state.pending = false;
+        if(reply && reply->status == XCB_GRAB_STATUS_SUCCESS)
         {
-            p_delete(&xgb);
-            return true;
+            p_delete(&reply);
+            keygrabber_grab_state.source = 0;
+            keygrabber_grab_notify(true);
+            return G_SOURCE_REMOVE;
         }
-        usleep(1000);
+        p_delete(&reply);
+        p_delete(&error);
+    }
+
+    if(g_get_monotonic_time() >= keygrabber_grab_state.deadline)
+    {
+        keygrabber_grab_state.source = 0;
+        keygrabber_grab_notify(false);
+        return G_SOURCE_REMOVE;
     }
-    return false;
+
+    keygrabber_grab_send();
+    return G_SOURCE_CONTINUE;
+}
+
+/** Start acquiring the keyboard grab.
+ */
+static void
+keygrabber_grab(void)
+{
+    keygrabber_grab_cancel();
+    keygrabber_grab_state.deadline = g_get_monotonic_time() + KEYGRABBER_GRAB_TIMEOUT;
+    keygrabber_grab_send();
+    keygrabber_grab_state.source =
+        g_timeout_add(KEYGRABBER_GRAB_INTERVAL, keygrabber_grab_check, NULL);
 }
 
 /** Returns, whether the \0-terminated char in UTF8 is control char.
@@ -117,6 +226,12 @@ keygrabber_handlekpress(lua_State *L, xcb_key_press_event_t *e)
  * * a string with the pressed key
  * * a string with either "press" or "release" to indicate the event type.
  *
+ * The keyboard is grabbed asynchronously: if another client holds the grab,
+ * awesome keeps retrying for up to a second without blocking. The outcome is
+ * reported with the `keygrabber::grab_acquired` and `keygrabber::grab_failed`
+ * signals of `awesome`. When the latter is emitted, the keygrabber is no
+ * longer running.
+ *
  * @param callback A callback function as described above.
  * @function run
  * @usage The following function can be bound to a key, and will be used to
@@ -142,12 +257,7 @@ luaA_keygrabber_run(lua_State *L)
         luaL_error(L, "keygrabber already running");
 
     luaA_registerfct(L, 1, &globalconf.keygrabber);
-
-    if(!keygrabber_grab())
-    {
-        luaA_unregister(L, &globalconf.keygrabber);
-        luaL_error(L, "unable to grab keyboard");
-    }
+    keygrabber_grab();
 
     return 0;
 }
@@ -158,6 +268,7 @@ luaA_keygrabber_run(lua_State *L)
 int
 luaA_keygrabber_stop(lua_State *L)
 {
+    keygrabber_grab_cancel();
     xcb_ungrab_keyboard(globalconf.connection, XCB_CURRENT_TIME);
     luaA_unregister(L, &globalconf.keygrabber);
     return 0;
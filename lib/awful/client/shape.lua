@@ -8,6 +8,7 @@
 
 -- Grab environment we need
 local surface = require("gears.surface")
+local gshape = require("gears.shape")
 local cairo = require("lgi").cairo
 local capi =
 {
@@ -91,10 +92,42 @@ function shape.update.all(c)
     shape.update.clip(c)
 end
 
+-- Get the native description of a client's shape, when it doesn't have to be
+-- drawn.
+local function get_native(c, shape_name)
+    if not c._shape then return end
+
+    local geom = c:geometry()
+    local bw = c.border_width
+    local native = gshape.native_description(c._shape, geom.width + 2*bw, geom.height + 2*bw)
+    if not native then return end
+
+    -- The client's own shape has to be combined with ours
+    local shape_img = surface.load_silently(c["client_shape_" .. shape_name], false)
+    if shape_img then
+        shape_img:finish()
+        return
+    end
+
+    if shape_name == "clip" then
+        -- Same as the bounding shape, without the border
+        native.x, native.y = -bw, -bw
+        native.width, native.height = geom.width + 2*bw, geom.height + 2*bw
+        native.inset = bw
+    end
+    return native
+end
+
 --- Update a client's bounding shape from the shape the client set itself.
 -- @function awful.client.shape.update.bounding
 -- @client c The client to act on
 function shape.update.bounding(c)
+    local native = get_native(c, "bounding")
+    if native then
+        c.shape_bounding = native
+        return
+    end
+
     local res = shape.get_transformed(c, "bounding")
     c.shape_bounding = res and res._native
     -- Free memory
@@ -107,6 +140,12 @@ end
 -- @function awful.client.shape.update.clip
 -- @client c The client to act on
 function shape.update.clip(c)
+    local native = get_native(c, "clip")
+    if native then
+        c.shape_clip = native
+        return
+    end
+
     local res = shape.get_transformed(c, "clip")
     c.shape_clip = res and res._native
     -- Free memory
@@ -10,13 +10,23 @@
 ---------------------------------------------------------------------------
 
 -- Grab environment we need
-local io = io
 local os = os
 local table = table
 local math = math
-local print = print
 local pairs = pairs
+local ipairs = ipairs
+local type = type
 local string = string
+local lgi = require("lgi")
+local Gio = lgi.Gio
+local GLib = lgi.GLib
+local protected_call = require("gears.protected_call")
+local gdebug = require("gears.debug")
+
+local capi =
+{
+    awesome = awesome,
+}
 
 local completion = {}
 
@@ -24,25 +34,190 @@ local completion = {}
 local bashcomp_funcs = {}
 local bashcomp_src = "@SYSCONFDIR@/bash_completion"
 
+-- Line printed by the completion helpers after each reply
+local HELPER_DONE = "--awesome-completion-done--"
+
+-- Time after which a helper which did not answer is killed, in milliseconds
+local HELPER_TIMEOUT = 5000
+
+-- Long-lived shells answering completion requests, by shell name. Each one
+-- has its pid, its stdin stream, the data waiting to be written to it, the
+-- requests in flight, and the lines of the reply being read.
+local helpers = {}
+
+-- The aliases, builtins, functions and keywords of each shell, sorted
+local shell_names = {}
+
+-- The executables found in $PATH: the directories, their listings (with
+-- their modification time) and all names, sorted.
+local commands = { path = nil, dirs = {}, listings = {}, names = nil }
+
+-- Whether the executable index is being warmed while idle
+local warming = false
+
+local function quote(str)
+    return "'" .. str:gsub("'", "'\\''") .. "'"
+end
+
+local function sorted_unique(list)
+    table.sort(list)
+    local ret = {}
+    for _, v in ipairs(list) do
+        if v ~= ret[#ret] then
+            table.insert(ret, v)
+        end
+    end
+    return ret
+end
+
+--- Forget about a helper and answer its pending requests with nothing.
+-- @param helper The helper.
+local function helper_stop(helper)
+    if helpers[helper.shell] == helper then
+        helpers[helper.shell] = nil
+    end
+    local requests = helper.requests
+    helper.requests = {}
+    helper.queue = {}
+    for _, request in ipairs(requests) do
+        if request.timeout then
+            GLib.source_remove(request.timeout)
+        end
+        protected_call(request.callback, {})
+    end
+end
+
+--- Write the queued requests to a helper without blocking when its stdin
+-- is full.
+-- @param helper The helper.
+local function helper_write(helper)
+    if helper.writing or #helper.queue == 0 then
+        return
+    end
+    local data = table.remove(helper.queue, 1)
+    helper.writing = true
+    helper.stdin:write_bytes_async(GLib.Bytes.new(data), GLib.PRIORITY_DEFAULT, nil, function(stream, result)
+        helper.writing = false
+        local written = stream:write_bytes_finish(result)
+        if not written or written < 0 then
+            -- The shell is gone, reading its stdout answers the requests
+            helper.queue = {}
+            return
+        end
+        if written < #data then
+            table.insert(helper.queue, 1, data:sub(written + 1))
+        end
+        helper_write(helper)
+    end)
+end
+
+--- Get a long-lived shell for completion requests.
+-- @tparam string shell The shell, "bash" or "zsh".
+-- @return The helper, or nil if it could not be started.
+local function get_helper(shell)
+    if helpers[shell] then
+        return helpers[shell]
+    end
+    if not capi.awesome then
+        return nil
+    end
+
+    local helper = { shell = shell, queue = {}, requests = {}, reply = {} }
+    local pid, _, stdin, stdout = capi.awesome.spawn({ "/usr/bin/env", shell },
+        false, true, true, false, function()
+            if helpers[shell] == helper then
+                helpers[shell] = nil
+            end
+        end)
+    if type(pid) == "string" then
+        gdebug.print_warning("awful.completion: cannot start " .. shell .. ": " .. pid)
+        return nil
+    end
+
+    helper.pid = pid
+    helper.stdin = Gio.UnixOutputStream.new(stdin, true)
+    require("awful.spawn").read_lines(Gio.UnixInputStream.new(stdout, true), function(line)
+        if line ~= HELPER_DONE then
+            table.insert(helper.reply, line)
+            return
+        end
+        local reply = helper.reply
+        helper.reply = {}
+        local request = table.remove(helper.requests, 1)
+        if request then
+            GLib.source_remove(request.timeout)
+            protected_call(request.callback, reply)
+        end
+    end, function()
+        -- The shell is gone: answer the pending requests with nothing
+        helper_stop(helper)
+    end, true)
+
+    helpers[shell] = helper
+
+    -- Learn the command names only known to the shell
+    local names_cmd
+    if shell == "zsh" then
+        names_cmd = "print -rl -- ${(k)aliases} ${(k)builtins} ${(k)functions} ${(k)reswords}"
+    else
+        names_cmd = "compgen -A alias -A builtin -A function -A keyword"
+    end
+    completion.helper_request(shell, names_cmd, function(names)
+        shell_names[shell] = sorted_unique(names)
+    end)
+
+    return helper
+end
+
+--- Send a script to a long-lived shell and get its output asynchronously.
+-- The shell is started on first use and keeps its state between requests,
+-- so that e.g. bash completion only has to be loaded once. The script's
+-- stdin is /dev/null. If the shell does not answer within a few seconds, it
+-- is killed and started again on the next request.
+-- @tparam string shell The shell, "bash" or "zsh".
+-- @tparam string script The script to run.
+-- @tparam function callback Called with the table of the lines the script
+--   printed on stdout, or with an empty table if the shell did not answer.
+-- @treturn boolean Whether the request was sent.
+function completion.helper_request(shell, script, callback)
+    local helper = get_helper(shell)
+    if not helper then
+        return false
+    end
+
+    local request = { callback = callback }
+    request.timeout = GLib.timeout_add(GLib.PRIORITY_DEFAULT, HELPER_TIMEOUT, function()
+        request.timeout = nil
+        gdebug.print_warning("awful.completion: " .. shell .. " did not answer, restarting it")
+        capi.awesome.kill(helper.pid, 9)
+        helper_stop(helper)
+        return false
+    end)
+    table.insert(helper.requests, request)
+
+    -- The script must not read the next requests from the shell's stdin
+    table.insert(helper.queue, "{\n" .. script .. "\n} </dev/null\n" ..
+                 "printf '%s\\n' " .. quote(HELPER_DONE) .. "\n")
+    helper_write(helper)
+    return true
+end
+
 --- Enable programmable bash completion in awful.completion.bash at the price of
 -- a slight overhead.
+-- The completion file is loaded once into a long-lived bash which then
+-- answers the completion requests.
 -- @param src The bash completion source file, /etc/bash_completion by default.
 function completion.bashcomp_load(src)
     if src then bashcomp_src = src end
-    local c, err = io.popen("/usr/bin/env bash -c 'source " .. bashcomp_src .. "; complete -p'")
-    if c then
-        while true do
-            local line = c:read("*line")
-            if not line then break end
-            -- if a bash function is used for completion, register it
-            if line:match(".* -F .*") then
-                bashcomp_funcs[line:gsub(".* (%S+)$","%1")] = line:gsub(".*-F +(%S+) .*$", "%1")
+    completion.helper_request("bash", "source " .. quote(bashcomp_src) .. " >/dev/null 2>&1; complete -p",
+        function(lines)
+            for _, line in ipairs(lines) do
+                -- if a bash function is used for completion, register it
+                if line:match(".* -F .*") then
+                    bashcomp_funcs[line:gsub(".* (%S+)$","%1")] = line:gsub(".*-F +(%S+) .*$", "%1")
+                end
             end
-        end
-        c:close()
-    else
-        print(err)
-    end
+        end)
 end
 
 local function bash_escape(str)
@@ -54,13 +229,240 @@ local function bash_escape(str)
     return str
 end
 
+local function stamp(path)
+    local info = Gio.File.new_for_path(path):query_info("time::modified,time::modified-usec",
+                                                        Gio.FileQueryInfoFlags.NONE)
+    if not info then
+        return false
+    end
+    return string.format("%d.%06d",
+                         info:get_attribute_uint64("time::modified"),
+                         info:get_attribute_uint32("time::modified-usec"))
+end
+
+local function is_dir(path)
+    return Gio.File.new_for_path(path):query_file_type({}) == "DIRECTORY"
+end
+
+-- Call fn with the name and the file info of each entry of a directory.
+local function list_dir(path, attributes, fn)
+    local enum = Gio.File.new_for_path(path):enumerate_children(attributes,
+                                                                Gio.FileQueryInfoFlags.NONE)
+    if not enum then
+        return
+    end
+    while true do
+        local info = enum:next_file()
+        if not info then
+            break
+        end
+        fn(info:get_name(), info)
+    end
+    enum:close()
+end
+
+--- Update the index of the executables in $PATH.
+-- Only directories which changed since they were last listed are listed
+-- again.
+-- @tparam[opt] number limit The maximal number of directories to list.
+-- @treturn boolean Whether all directories are up to date.
+local function update_commands(limit)
+    local path = os.getenv("PATH") or ""
+    if path ~= commands.path then
+        commands.path = path
+        commands.dirs = {}
+        commands.names = nil
+        for dir in path:gmatch("[^:]+") do
+            table.insert(commands.dirs, dir)
+        end
+    end
+
+    local listed = 0
+    for _, dir in ipairs(commands.dirs) do
+        local st = stamp(dir)
+        local listing = commands.listings[dir]
+        if not listing or listing.stamp ~= st then
+            if limit and listed >= limit then
+                return false
+            end
+            listing = { stamp = st, names = {} }
+            if st then
+                list_dir(dir, "standard::name,standard::type,access::can-execute", function(name, info)
+                    if info:get_file_type() ~= "DIRECTORY"
+                            and info:get_attribute_boolean("access::can-execute") then
+                        table.insert(listing.names, name)
+                    end
+                end)
+            end
+            commands.listings[dir] = listing
+            commands.names = nil
+            listed = listed + 1
+        end
+    end
+
+    if not commands.names then
+        local names = {}
+        for _, dir in ipairs(commands.dirs) do
+            for _, name in ipairs(commands.listings[dir].names) do
+                table.insert(names, name)
+            end
+        end
+        commands.names = sorted_unique(names)
+    end
+    return true
+end
+
+-- Append the names of a sorted list starting with a prefix to a table.
+local function prefix_matches(sorted, prefix, ret)
+    local lo, hi = 1, #sorted + 1
+    while lo < hi do
+        local mid = math.floor((lo + hi) / 2)
+        if sorted[mid] < prefix then
+            lo = mid + 1
+        else
+            hi = mid
+        end
+    end
+    for i = lo, #sorted do
+        if sorted[i]:sub(1, #prefix) ~= prefix then
+            break
+        end
+        table.insert(ret, sorted[i])
+    end
+    return ret
+end
+
+local function command_matches(word, shell)
+    update_commands()
+    local ret = prefix_matches(commands.names, word, {})
+    if shell_names[shell] then
+        prefix_matches(shell_names[shell], word, ret)
+    else
+        -- Start the helper, its names are used for the next completions
+        get_helper(shell)
+    end
+    ret = sorted_unique(ret)
+    for i, v in ipairs(ret) do
+        ret[i] = bash_escape(v)
+    end
+    return ret
+end
+
+local function file_matches(word)
+    word = word:gsub("\\(.)", "%1")
+    local dir, base = word:match("^(.*/)([^/]*)$")
+    if not dir then
+        dir, base = "", word
+    end
+    local path = dir
+    if path == "" then
+        path = "."
+    elseif path:sub(1, 2) == "~/" then
+        path = (os.getenv("HOME") or "") .. path:sub(2)
+    end
+
+    local ret = {}
+    list_dir(path, "standard::name,standard::type", function(name, info)
+        if name:sub(1, #base) == base and (name:sub(1, 1) ~= "." or base:sub(1, 1) == ".") then
+            table.insert(ret, bash_escape(dir .. name .. (info:get_file_type() == "DIRECTORY" and "/" or "")))
+        end
+    end)
+    return sorted_unique(ret)
+end
+
+-- Warm the executable index while idle, one directory at a time.
+local function start_warming()
+    if warming then
+        return
+    end
+    warming = true
+    GLib.idle_add(GLib.PRIORITY_LOW, function()
+        return not update_commands(1)
+    end)
+end
+
+local function complete(command, cur_pos, ncomp, cword_start, cword_end, output)
+    -- no completion, return
+    if #output == 0 then
+        return command, cur_pos
+    end
+
+    -- cycle
+    while ncomp > #output do
+        ncomp = ncomp - #output
+    end
+
+    local str = command:sub(1, cword_start - 1) .. output[ncomp] .. command:sub(cword_end)
+    cur_pos = cword_end + #output[ncomp] + 1
+
+    return str, cur_pos, output
+end
+
+-- The last reply of a completion through a helper, and the request in flight
+local helper_reply = { key = nil, output = nil }
+local helper_pending = { key = nil, callback = nil }
+
+--- Complete a file name or an argument through a helper shell.
+-- @tparam string shell The shell.
+-- @tparam string key What identifies the completion request.
+-- @tparam string script The script printing the matches.
+-- @tparam string word The word to complete, used if the helper is unavailable.
+-- @tparam function callback Called with the matches once they are known.
+-- @return The matches, or nothing if they are passed to the callback later.
+local function helper_matches(shell, key, script, word, callback)
+    key = shell .. "\0" .. key
+    if helper_reply.key == key then
+        return helper_reply.output
+    end
+
+    helper_pending.callback = callback
+    if helper_pending.key == key then
+        -- Already asked, the reply will go to the new callback
+        return
+    end
+
+    local sent = completion.helper_request(shell, script, function(lines)
+        for j, line in ipairs(lines) do
+            if is_dir(line) then
+                line = line .. "/"
+            end
+            lines[j] = bash_escape(line)
+        end
+        helper_reply.key, helper_reply.output = key, sorted_unique(lines)
+        if helper_pending.key == key then
+            local pending = helper_pending.callback
+            helper_pending.key, helper_pending.callback = nil, nil
+            pending(helper_reply.output)
+        end
+    end)
+    if sent then
+        helper_pending.key = key
+        return
+    end
+    helper_pending.callback = nil
+    return file_matches(word)
+end
+
 --- Use shell completion system to complete command and filename.
+-- Command names are looked up in an index of $PATH and file names are listed
+-- directly, without starting a shell. Programmable bash completion (see
+-- `bashcomp_load`) and zsh file name completion, which expands globs and
+-- "~", are answered by a long-lived shell, so they need the callback to be
+-- asynchronous; without one, file names are listed directly instead.
 -- @param command The command line.
 -- @param cur_pos The cursor position.
 -- @param ncomp The element number to complete.
 -- @param shell The shell to use for completion (bash (default) or zsh).
--- @return The new command, the new cursor position, the table of all matches.
-function completion.shell(command, cur_pos, ncomp, shell)
+-- @tparam[opt] function callback Called with the results when they are not
+--   available immediately. It is also accepted in place of `shell`.
+-- @return The new command, the new cursor position, the table of all matches,
+--   or nothing if the results are passed to the callback later.
+function completion.shell(command, cur_pos, ncomp, shell, callback)
+    if type(shell) == "function" then
+        shell, callback = nil, shell
+    end
+    start_warming()
+
     local wstart = 1
     local wend = 1
     local words = {}
@@ -94,67 +496,47 @@ function completion.shell(command, cur_pos, ncomp, shell)
         comptype = "command"
     end
 
-    local shell_cmd
-    if shell == "zsh" or (not shell and os.getenv("SHELL"):match("zsh$")) then
-        if comptype == "file" then
-            -- NOTE: ${~:-"..."} turns on GLOB_SUBST, useful for expansion of
-            -- "~/" ($HOME).  ${:-"foo"} is the string "foo" as var.
-            shell_cmd = "/usr/bin/env zsh -c 'local -a res; res=( ${~:-"
-                .. string.format('%q', words[cword_index]) .. "}* ); "
-                .. "print -ln -- ${res[@]}'"
-        else
-            -- check commands, aliases, builtins, functions and reswords
-            shell_cmd = "/usr/bin/env zsh -c 'local -a res; "..
-            "res=( "..
-            "\"${(k)commands[@]}\" \"${(k)aliases[@]}\" \"${(k)builtins[@]}\" \"${(k)functions[@]}\" \"${(k)reswords[@]}\" "..
-            "${PWD}/*(:t)"..
-            "); "..
-            "print -ln -- ${(M)res[@]:#" .. string.format('%q', words[cword_index]) .. "*}'"
-        end
+    if shell == "zsh" or (not shell and (os.getenv("SHELL") or ""):match("zsh$")) then
+        shell = "zsh"
     else
-        if bashcomp_funcs[words[1]] then
-            -- fairly complex command with inline bash script to get the possible completions
-            shell_cmd = "/usr/bin/env bash -c 'source " .. bashcomp_src .. "; " ..
-            "__print_completions() { for ((i=0;i<${#COMPREPLY[*]};i++)); do echo ${COMPREPLY[i]}; done }; " ..
-            "COMP_WORDS=(" ..  command .."); COMP_LINE=\"" .. command .. "\"; " ..
-            "COMP_COUNT=" .. cur_pos ..  "; COMP_CWORD=" .. cword_index-1 .. "; " ..
-            bashcomp_funcs[words[1]] .. "; __print_completions'"
-        else
-            shell_cmd = "/usr/bin/env bash -c 'compgen -A " .. comptype .. " "
-                .. string.format('%q', words[cword_index]) .. "'"
-        end
+        shell = "bash"
     end
-    local c, err = io.popen(shell_cmd .. " | sort -u")
-    local output = {}
-    if c then
-        while true do
-            local line = c:read("*line")
-            if not line then break end
-            if os.execute("test -d " .. string.format('%q', line)) == 0 then
-                line = line .. "/"
-            end
-            table.insert(output, bash_escape(line))
-        end
 
-        c:close()
+    local output, script
+    if comptype == "command" then
+        output = command_matches(words[cword_index], shell)
+    elseif callback and shell == "bash" and bashcomp_funcs[words[1]] then
+        local comp_words = {}
+        for _, w in ipairs(words) do
+            table.insert(comp_words, quote(w))
+        end
+        script = "COMP_WORDS=(" .. table.concat(comp_words, " ") .. "); " ..
+            "COMP_LINE=" .. quote(command) .. "; " ..
+            "COMP_POINT=" .. (cur_pos - 1) .. "; COMP_CWORD=" .. (cword_index - 1) .. "; " ..
+            "COMPREPLY=(); " ..
+            bashcomp_funcs[words[1]] .. " " .. quote(words[1]) .. " " ..
+            quote(words[cword_index]) .. " " .. quote(words[cword_index - 1] or "") ..
+            " >/dev/null 2>&1; " ..
+            "for r in \"${COMPREPLY[@]}\"; do printf '%s\\n' \"$r\"; done"
+    elseif callback and shell == "zsh" then
+        -- ${~:-...} turns on GLOB_SUBST, so that globs and "~" are expanded
+        -- like zsh does on the command line.
+        local word = words[cword_index]:gsub("\\(.)", "%1")
+        script = "local -a res; res=( ${~:-" .. quote(word) .. "}*(N) ); print -rl -- $res"
     else
-        print(err)
-    end
-
-    -- no completion, return
-    if #output == 0 then
-        return command, cur_pos
+        output = file_matches(words[cword_index])
     end
 
-    -- cycle
-    while ncomp > #output do
-        ncomp = ncomp - #output
+    if script then
+        output = helper_matches(shell, command .. "\0" .. cur_pos, script, words[cword_index], function(reply)
+            callback(complete(command, cur_pos, ncomp, cword_start, cword_end, reply))
+        end)
+        if not output then
+            return
+        end
     end
 
-    local str = command:sub(1, cword_start - 1) .. output[ncomp] .. command:sub(cword_end)
-    cur_pos = cword_end + #output[ncomp] + 1
-
-    return str, cur_pos, output
+    return complete(command, cur_pos, ncomp, cword_start, cword_end, output)
 end
 
 --- Run a generic completion.
@@ -7,6 +7,7 @@
 ---------------------------------------------------------------------------
 
 local capi = {
+    awesome = awesome,
     screen = screen,
     client = client,
     keygrabber = keygrabber,
@@ -517,6 +518,13 @@ function widget.new(args)
         local help_wibox = self._cached_wiboxes[s][joined_groups]
         help_wibox:show()
 
+        -- Without the keyboard, the popup could never be dismissed
+        local function grab_failed()
+            capi.awesome.disconnect_signal("keygrabber::grab_failed", grab_failed)
+            help_wibox:hide()
+        end
+        capi.awesome.connect_signal("keygrabber::grab_failed", grab_failed)
+
         return capi.keygrabber.run(function(_, key, event)
             if event == "release" then return end
             if key then
@@ -526,6 +534,7 @@ function widget.new(args)
                     help_wibox:page_prev()
                 else
                     capi.keygrabber.stop()
+                    capi.awesome.disconnect_signal("keygrabber::grab_failed", grab_failed)
                     help_wibox:hide()
                 end
             end
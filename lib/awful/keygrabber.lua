@@ -9,6 +9,7 @@
 local ipairs = ipairs
 local table = table
 local capi = {
+    awesome = awesome,
     keygrabber = keygrabber }
 
 local keygrabber = {}
@@ -58,6 +59,9 @@ end
 -- * a string with the pressed key
 -- * a string with either "press" or "release" to indicate the event type
 --
+-- If the keyboard could not be grabbed, `awesome` emits
+-- `keygrabber::grab_failed` and all callbacks are removed from the stack.
+--
 -- A callback can return `false` to pass the events to the next
 -- keygrabber in the stack.
 -- @param g The key grabber callback that will get the key events until it will be deleted or a new grabber is added.
@@ -91,6 +95,12 @@ function keygrabber.run(g)
     return g
 end
 
+-- The C keygrabber already stopped itself, forget about all grabbers.
+capi.awesome.connect_signal("keygrabber::grab_failed", function()
+    grabbers = {}
+    keygrabbing = false
+end)
+
 return keygrabber
 
 -- vim: filetype=lua:expandtab:shiftwidth=4:tabstop=8:softtabstop=4:textwidth=80
@@ -203,13 +203,16 @@ function layout.arrange(screen)
 
         p.geometries = setmetatable({}, {__mode = "k"})
         layout.get(screen).arrange(p)
-        for c, g in pairs(p.geometries) do
-            g.width = math.max(1, g.width - c.border_width * 2 - useless_gap * 2)
-            g.height = math.max(1, g.height - c.border_width * 2 - useless_gap * 2)
-            g.x = g.x + useless_gap
-            g.y = g.y + useless_gap
-            c:geometry(g)
-        end
+        -- Each client emits its geometry signals once, after all were moved
+        capi.client.batch(function()
+            for c, g in pairs(p.geometries) do
+                g.width = math.max(1, g.width - c.border_width * 2 - useless_gap * 2)
+                g.height = math.max(1, g.height - c.border_width * 2 - useless_gap * 2)
+                g.x = g.x + useless_gap
+                g.y = g.y + useless_gap
+                c:geometry(g)
+            end
+        end)
         arrange_lock = false
         delayed_arrange[screen] = nil
 
@@ -306,14 +309,14 @@ capi.client.connect_signal("request::geometry", layout.move_handler)
 
 -- When a screen is moved, make (floating) clients follow it
 capi.screen.connect_signal("property::geometry", function(s, old_geom)
-    local geom = s.geometry
-    local xshift = geom.x - old_geom.x
-    local yshift = geom.y - old_geom.y
+    local x, y = s:unpacked_geometry()
+    local xshift = x - old_geom.x
+    local yshift = y - old_geom.y
     for _, c in ipairs(capi.client.get(s)) do
-        local cgeom = c:geometry()
+        local cx, cy = c:unpacked_geometry()
         c:geometry({
-            x = cgeom.x + xshift,
-            y = cgeom.y + yshift
+            x = cx + xshift,
+            y = cy + yshift
         })
     end
 end)
@@ -42,6 +42,14 @@ mouse.wibox = {}
 --- Enable client to client snapping.
 -- @tfield[opt=true] boolean awful.mouse.snap.client_enabled
 
+--- Move and resize floating clients from C.
+-- The geometry then follows the pointer without running the Lua placement
+-- and snapping code for each motion, which is much cheaper with large
+-- windows. Edge and client snapping still apply, but the snapping outline and
+-- `drag_to_tag` are not available.
+-- @tfield[opt=false] boolean awful.mouse.native_moveresize
+mouse.native_moveresize = false
+
 --- Enable changing tag when a client is dragged to the edge of the screen.
 -- @tfield[opt=false] integer awful.mouse.drag_to_tag.enabled
 
@@ -67,6 +75,58 @@ function mouse.client_under_pointer()
     return mouse.object.get_current_client()
 end
 
+-- Cursors of the native resize, by corner
+local resize_cursors = {
+    left         = "sb_h_double_arrow",
+    right        = "sb_h_double_arrow",
+    top          = "sb_v_double_arrow",
+    bottom       = "sb_v_double_arrow",
+    top_left     = "top_left_corner",
+    top_right    = "top_right_corner",
+    bottom_left  = "bottom_left_corner",
+    bottom_right = "bottom_right_corner",
+}
+
+--- Can a client be moved or resized by the native C implementation?
+-- @client c The client.
+-- @treturn boolean
+local function use_native_moveresize(c)
+    if not mouse.native_moveresize then return false end
+
+    local t = c.screen.selected_tag
+    local lay = t and t.layout or nil
+
+    return (lay and lay == layout.suit.floating) or c.floating
+end
+
+--- Move or resize a client with `mousegrabber.moveresize`.
+-- @client c The client.
+-- @tparam string mode Either "move" or "resize".
+-- @tparam[opt] string corner The corner to drag for a resize.
+-- @tparam[opt] integer snap The snapping distance.
+local function native_moveresize(c, mode, corner, snap)
+    local areas = {}
+
+    if mouse.snap.edge_enabled ~= false then
+        table.insert(areas, c.screen.workarea)
+    end
+    if mouse.snap.client_enabled ~= false then
+        for _, other in ipairs(c.screen.clients) do
+            if other ~= c then
+                table.insert(areas, other:geometry())
+            end
+        end
+    end
+
+    capi.mousegrabber.moveresize(c, {
+        mode       = mode,
+        corner     = corner,
+        cursor     = mode == "move" and "fleur" or resize_cursors[corner] or "cross",
+        snap       = snap or mouse.snap.default_distance,
+        snap_areas = areas,
+    })
+end
+
 --- Move a client.
 -- @function awful.mouse.client.move
 -- @param c The client to move, or the focused one if nil.
@@ -89,6 +149,10 @@ function mouse.client.move(c, snap, finished_cb) --luacheck: no unused args
         return
     end
 
+    if use_native_moveresize(c) then
+        return native_moveresize(c, "move", nil, snap)
+    end
+
     -- Compute the offset
     local coords = capi.mouse.coords()
     local geo    = aplace.centered(capi.mouse,{parent=c, pretend=true})
@@ -220,6 +284,11 @@ function mouse.client.resize(c, corner, args)
 
     new_args.corner = corner
 
+    if use_native_moveresize(c) then
+        native_moveresize(c, "resize", corner, new_args.snap)
+        return corner
+    end
+
     mouse.resize(c, "mouse.resize", new_args)
 
     return corner
@@ -415,6 +484,15 @@ end)
 --  when button 1 is pressed.
 -- @function mouse.coords
 
+--- Get the mouse coords without creating a table.
+--
+-- This is cheaper than `mouse.coords` for code that runs on every motion
+-- event and only needs the position.
+--
+-- @treturn integer The horizontal position
+-- @treturn integer The vertical position
+-- @function mouse.unpacked_coords
+
 
 return mouse
 
@@ -79,21 +79,22 @@ local function build_placement(snap, axis)
 end
 
 local function detect_screen_edges(c, snap)
-    local coords = capi.mouse.coords()
+    -- This runs on every motion event, avoid creating tables
+    local mx, my = capi.mouse.unpacked_coords()
 
-    local sg = c.screen.geometry
+    local sx, sy, sw, sh = c.screen:unpacked_geometry()
 
     local v, h = nil
 
-    if math.abs(coords.x) <= snap + sg.x and coords.x >= sg.x then
+    if math.abs(mx) <= snap + sx and mx >= sx then
         h = "left"
-    elseif math.abs((sg.x + sg.width) - coords.x) <= snap then
+    elseif math.abs((sx + sw) - mx) <= snap then
         h = "right"
     end
 
-    if math.abs(coords.y) <= snap + sg.y and coords.y >= sg.y then
+    if math.abs(my) <= snap + sy and my >= sy then
         v = "top"
-    elseif math.abs((sg.y + sg.height) - coords.y) <= snap then
+    elseif math.abs((sy + sh) - my) <= snap then
         v = "bottom"
     end
 
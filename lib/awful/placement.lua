@@ -684,11 +684,11 @@ local function get_relative_regions(geo, mode, is_absolute)
         geo.drawable = geo -- is a wibox or client, geometry and object are one
                            -- and the same.
     elseif (not geo.drawable) and geo.x and geo.width then
-        local coords = capi.mouse.coords()
+        local mx, my = capi.mouse.unpacked_coords()
 
         -- Check if the mouse is in the rect
-        if coords.x > geo.x and coords.x < geo.x+geo.width and
-          coords.y > geo.y and coords.y < geo.y+geo.height then
+        if mx > geo.x and mx < geo.x+geo.width and
+          my > geo.y and my < geo.y+geo.height then
             geo.drawable = capi.mouse.current_wibox
         end
 
@@ -925,11 +925,11 @@ function placement.under_mouse(d, args)
     args = add_context(args, "under_mouse")
     d = d or capi.client.focus
 
-    local m_coords = capi.mouse.coords()
+    local mx, my = capi.mouse.unpacked_coords()
 
     local ngeo = geometry_common(d, args)
-    ngeo.x = math.floor(m_coords.x - ngeo.width  / 2)
-    ngeo.y = math.floor(m_coords.y - ngeo.height / 2)
+    ngeo.x = math.floor(mx - ngeo.width  / 2)
+    ngeo.y = math.floor(my - ngeo.height / 2)
 
     local bw    = (not args.ignore_border_width) and d.border_width or 0
     ngeo.width  = ngeo.width  - 2*bw
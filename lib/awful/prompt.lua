@@ -118,6 +118,7 @@ local ipairs = ipairs
 local pcall = pcall
 local capi =
 {
+    awesome = awesome,
     selection = selection
 }
 local unpack = unpack or table.unpack -- luacheck: globals unpack (compatibility with Lua 5.1)
@@ -316,10 +317,16 @@ end
 --    return command_before_comp.."foo", cur_pos_before_comp+3, 1
 -- end
 --
+-- A callback which can't complete immediately returns nothing and calls
+-- `callback` with its results later. They are ignored if another key was
+-- pressed meanwhile.
+--
 -- @callback completion_callback
 -- @tparam string command_before_comp The current command.
 -- @tparam number cur_pos_before_comp The current cursor position.
 -- @tparam number ncomp The number of completion elements.
+-- @tparam function callback Function to call with the results when they are
+--   not returned.
 -- @treturn string command
 -- @treturn number cur_pos
 -- @treturn number matches
@@ -532,6 +539,8 @@ function prompt.run(args, textbox, exe_callback, completion_callback,
     local cur_pos = (selectall and 1) or text:wlen() + 1
     -- The completion element to use on completion request.
     local ncomp = 1
+    -- Incremented on key presses, to drop outdated asynchronous completions
+    local completion_serial = 0
     if not textbox then
         return
     end
@@ -557,10 +566,20 @@ function prompt.run(args, textbox, exe_callback, completion_callback,
         cursor_pos = cur_pos, cursor_ul = cur_ul, selectall = selectall,
         prompt = prettyprompt, highlighter =  highlighter})
 
+    -- Without the keyboard, the prompt can't be used
+    local function grab_failed()
+        capi.awesome.disconnect_signal("keygrabber::grab_failed", grab_failed)
+        completion_serial = completion_serial + 1
+        textbox:set_markup("")
+        history_save(history_path)
+        if done_callback then done_callback() end
+    end
+
     local function exec(cb, command_to_history)
         textbox:set_markup("")
         history_add(history_path, command_to_history)
         keygrabber.stop(grabber)
+        capi.awesome.disconnect_signal("keygrabber::grab_failed", grab_failed)
         if cb then cb(command) end
         if done_callback then done_callback() end
     end
@@ -574,12 +593,29 @@ function prompt.run(args, textbox, exe_callback, completion_callback,
                                prompt = prettyprompt, highlighter =  highlighter })
     end
 
+    -- Use the results of the completion callback
+    local function apply_completion(new_command, new_cur_pos, matches)
+        command, cur_pos = new_command, new_cur_pos
+        ncomp = ncomp + 1
+        -- execute if only one match found and autoexec flag set
+        if matches and #matches == 1 and args.autoexec then
+            exec(exe_callback)
+            return true
+        end
+        return false
+    end
+
+    capi.awesome.connect_signal("keygrabber::grab_failed", grab_failed)
     grabber = keygrabber.run(
     function (modifiers, key, event)
         -- Convert index array to hash table
         local mod = {}
         for _, v in ipairs(modifiers) do mod[v] = true end
 
+        if event == "press" then
+            completion_serial = completion_serial + 1
+        end
+
         if event ~= "press" then
             if args.keyreleased_callback then
                 args.keyreleased_callback(mod, key, command)
@@ -668,6 +704,7 @@ function prompt.run(args, textbox, exe_callback, completion_callback,
         if (mod.Control and (key == "c" or key == "g"))
             or (not mod.Control and key == "Escape") then
             keygrabber.stop(grabber)
+            capi.awesome.disconnect_signal("keygrabber::grab_failed", grab_failed)
             textbox:set_markup("")
             history_save(history_path)
             if done_callback then done_callback() end
@@ -836,15 +873,28 @@ function prompt.run(args, textbox, exe_callback, completion_callback,
                         command_before_comp = command
                         cur_pos_before_comp = cur_pos
                     end
-                    local matches
-                    command, cur_pos, matches = completion_callback(command_before_comp, cur_pos_before_comp, ncomp)
-                    ncomp = ncomp + 1
-                    key = ""
-                    -- execute if only one match found and autoexec flag set
-                    if matches and #matches == 1 and args.autoexec then
-                        exec(exe_callback)
+                    local serial = completion_serial
+                    local new_command, new_cur_pos, matches = completion_callback(
+                        command_before_comp, cur_pos_before_comp, ncomp,
+                        function(async_command, async_cur_pos, async_matches)
+                            if serial ~= completion_serial
+                                    or apply_completion(async_command, async_cur_pos, async_matches) then
+                                return
+                            end
+                            selectall = nil
+                            update()
+                            if changed_callback then
+                                changed_callback(command)
+                            end
+                        end)
+                    if not new_command then
+                        -- The results will be passed to the callback
+                        return
+                    end
+                    if apply_completion(new_command, new_cur_pos, matches) then
                         return
                     end
+                    key = ""
                 else
                     ncomp = 1
                 end
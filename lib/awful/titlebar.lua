@@ -281,7 +281,15 @@ local function new(c, args)
             position = position
         }
         ret = drawable(d, context, "awful.titlebar")
-        ret:_inform_visible(true)
+
+        -- Only draw the titlebar while its client is mapped
+        ret:_inform_visible(not c.banned)
+        local function update_visible()
+            ret:_inform_visible(not c.banned)
+            -- The frame is mapped right after the client is unbanned, so
+            -- catch up immediately
+            ret:_redraw_now()
+        end
         local function update_colors()
             local args_ = bars[position].args
             ret:set_bg(get_color("bg", c, args_))
@@ -299,8 +307,13 @@ local function new(c, args)
         c:connect_signal("focus", update_colors)
         c:connect_signal("unfocus", update_colors)
 
+        c:connect_signal("property::banned", update_visible)
+
         -- Inform the drawable when it becomes invisible
-        c:connect_signal("unmanage", function() ret:_inform_visible(false) end)
+        c:connect_signal("unmanage", function()
+            c:disconnect_signal("property::banned", update_visible)
+            ret:_inform_visible(false)
+        end)
     else
         bars[position].args = args
         ret = bars[position].drawable
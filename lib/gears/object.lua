@@ -25,19 +25,63 @@ local function check(obj)
 end
 
 --- Find a given signal
+--
+-- The handlers of a signal are kept in an array, in the order in which they
+-- were connected. Strong handlers are stored directly, weak handlers are
+-- stored as a weak table. `modes` maps each handler to "strong" or "weak".
+--
+-- Connecting a handler appends to the array, while disconnecting one replaces
+-- the array with a copy. Since an emission only looks at the handlers that
+-- were connected when it started, this is safe during an emission.
 -- @tparam table obj The object to search in
 -- @tparam string name The signal to find
 -- @treturn table The signal table
 local function find_signal(obj, name)
     check(obj)
-    if not obj._signals[name] then
+    local sig = obj._signals[name]
+    if not sig then
         assert(type(name) == "string", "name must be a string, got: " .. type(name))
-        obj._signals[name] = {
-            strong = {},
-            weak = setmetatable({}, { __mode = "kv" })
+        sig = {
+            handlers = {},
+            count = 0,
+            modes = setmetatable({}, { __mode = "k" })
         }
+        obj._signals[name] = sig
+    end
+    return sig
+end
+
+--- Get the function of a handler.
+-- @param handler A function or a weak handler.
+-- @treturn function|nil The function, or nil if it was garbage collected.
+local function handler_function(handler)
+    if type(handler) == "function" then
+        return handler
+    end
+    return handler.token ~= nil and handler.func or nil
+end
+
+--- Replace the handlers of a signal by the ones that are still alive.
+-- @tparam table sig The signal table
+-- @tparam[opt] function removed A function to leave out as well.
+local function rebuild_handlers(sig, removed)
+    local old = sig.handlers
+    local handlers, count = {}, 0
+    for i = 1, sig.count do
+        local func = handler_function(old[i])
+        if func and func ~= removed then
+            count = count + 1
+            handlers[count] = old[i]
+        end
     end
-    return obj._signals[name]
+    sig.handlers, sig.count = handlers, count
+end
+
+local function add_handler(sig, func, mode, handler)
+    local count = sig.count + 1
+    sig.modes[func] = mode
+    sig.handlers[count] = handler
+    sig.count = count
 end
 
 function object.add_signal()
@@ -51,8 +95,11 @@ end
 function object:connect_signal(name, func)
     assert(type(func) == "function", "callback must be a function, got: " .. type(func))
     local sig = find_signal(self, name)
-    assert(sig.weak[func] == nil, "Trying to connect a strong callback which is already connected weakly")
-    sig.strong[func] = true
+    local mode = sig.modes[func]
+    assert(mode ~= "weak", "Trying to connect a strong callback which is already connected weakly")
+    if not mode then
+        add_handler(sig, func, "strong", func)
+    end
 end
 
 local function make_the_gc_obey(func)
@@ -85,6 +132,8 @@ local function make_the_gc_obey(func)
     return func
 end
 
+local weak_handler_mt = { __mode = "v" }
+
 --- Connect to a signal weakly. This allows the callback function to be garbage
 -- collected and automatically disconnects the signal when that happens.
 -- @tparam string name The name of the signal
@@ -92,8 +141,14 @@ end
 function object:weak_connect_signal(name, func)
     assert(type(func) == "function", "callback must be a function, got: " .. type(func))
     local sig = find_signal(self, name)
-    assert(sig.strong[func] == nil, "Trying to connect a weak callback which is already connected strongly")
-    sig.weak[func] = make_the_gc_obey(func)
+    local mode = sig.modes[func]
+    assert(mode ~= "strong", "Trying to connect a weak callback which is already connected strongly")
+    if not mode then
+        -- The token is what tells whether the function is still alive, see
+        -- make_the_gc_obey()
+        local handler = setmetatable({ func = func, token = make_the_gc_obey(func) }, weak_handler_mt)
+        add_handler(sig, func, "weak", handler)
+    end
 end
 
 --- Disonnect to a signal.
@@ -101,23 +156,37 @@ end
 -- @tparam function func The callback that should be disconnected
 function object:disconnect_signal(name, func)
     local sig = find_signal(self, name)
-    sig.weak[func] = nil
-    sig.strong[func] = nil
+    if sig.modes[func] then
+        sig.modes[func] = nil
+        rebuild_handlers(sig, func)
+    end
 end
 
 --- Emit a signal.
 --
+-- The callbacks are called in the order in which they were connected.
+-- Callbacks connected or disconnected by a callback only take effect for the
+-- next emission.
+--
 -- @tparam string name The name of the signal
 -- @param ... Extra arguments for the callback functions. Each connected
 --   function receives the object as first argument and then any extra arguments
 --   that are given to emit_signal()
 function object:emit_signal(name, ...)
     local sig = find_signal(self, name)
-    for func in pairs(sig.strong) do
-        func(self, ...)
+    local handlers, dead = sig.handlers, false
+    for i = 1, sig.count do
+        local func = handlers[i]
+        if type(func) ~= "function" then
+            func = handler_function(func)
+            dead = dead or not func
+        end
+        if func then
+            func(self, ...)
+        end
     end
-    for func in pairs(sig.weak) do
-        func(self, ...)
+    if dead then
+        rebuild_handlers(sig)
     end
 end
 
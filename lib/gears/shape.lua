@@ -652,6 +652,68 @@ function module.transform(shape)
     return result
 end
 
+--- Create a shape which awesome can also apply to windows without drawing it.
+--
+-- Used as the shape of a client or a wibox, such a shape is turned into a
+-- list of rectangles by awesome itself, which is cached per size. Other shapes
+-- are drawn into a bitmap whenever the window is resized. The shape functions
+-- `rectangle`, `rounded_rect`, `rounded_bar` and `circle` also get this
+-- treatment when used with their default arguments.
+--
+-- @usage c.shape = gears.shape.native("rounded_rect", 5)
+--
+-- @tparam string name The name of the shape: "rectangle", "rounded_rect",
+--   "rounded_bar", "partially_rounded_rect" or "circle".
+-- @param ... The arguments of the shape function after the size.
+-- @return A shape function (a callable table).
+function module.native(name, ...)
+    assert(module[name], "Unknown shape: " .. tostring(name))
+    local args = {...}
+    return setmetatable({ _native = { name = name, args = args } }, {
+        __call = function(_, cr, width, height)
+            return module[name](cr, width, height, unpack(args))
+        end
+    })
+end
+
+local native_functions = {
+    [module.rectangle] = "rectangle",
+    [module.rounded_rect] = "rounded_rect",
+    [module.rounded_bar] = "rounded_bar",
+    [module.circle] = "circle",
+}
+
+--- Describe a shape for the native `shape_bounding`, `shape_clip` and
+-- `shape_input` properties of clients and drawins.
+-- @param shape A shape function.
+-- @tparam number width The width of the shape.
+-- @tparam number height The height of the shape.
+-- @treturn table|nil The description, or nil if the shape has to be drawn.
+-- @see native
+function module.native_description(shape, width, height)
+    local name, args
+    if type(shape) == "table" and shape._native then
+        name, args = shape._native.name, shape._native.args
+    elseif native_functions[shape] then
+        name, args = native_functions[shape], {}
+    else
+        return nil
+    end
+
+    if name == "rectangle" then
+        return { shape = "rectangle" }
+    elseif name == "rounded_rect" then
+        return { shape = "rounded_rect", radius = args[1] or 10 }
+    elseif name == "rounded_bar" then
+        return { shape = "rounded_rect", radius = height / 2 }
+    elseif name == "partially_rounded_rect" then
+        return { shape = "partially_rounded_rect", tl = args[1], tr = args[2],
+                 br = args[3], bl = args[4], radius = args[5] or 10 }
+    elseif name == "circle" then
+        return { shape = "circle", radius = args[1] or math.min(width, height) / 2 }
+    end
+end
+
 return module
 
 -- vim: filetype=lua:expandtab:shiftwidth=4:tabstop=8:softtabstop=4:textwidth=80
@@ -13,9 +13,14 @@
 local beautiful = require("beautiful")
 local awful_util = require("awful.util")
 local GLib = require("lgi").GLib
+local Gio = require("lgi").Gio
 local index_theme = require("menubar.index_theme")
 
+local io = io
+local os = os
 local ipairs = ipairs
+local pairs = pairs
+local pcall = pcall
 local setmetatable = setmetatable
 local string = string
 local table = table
@@ -75,9 +80,193 @@ end
 
 local icon_theme = { mt = {} }
 
-local index_theme_cache = {}
+--- Path of the file caching the listings of the icon directories.
+-- Set it to `false` before the first lookup to disable the on-disk cache.
+icon_theme.cache_file = awful_util.get_cache_dir() .. "icon_theme_cache"
+
+local CACHE_VERSION = "icon_theme cache 1"
+
+-- Number of directories checked for changes per idle callback
+local REFRESH_BATCH = 32
+
+-- Directory listings, by path: the modification time of the directory (false
+-- if it does not exist) and the set of names it contains. Icon lookups only
+-- ever consult these, so a lookup does not touch the file system unless a
+-- directory is seen for the first time.
+local listings = nil
+
+-- Incremented whenever a listing changes, to invalidate the icon maps
+local generation = 0
+
+-- Paths of the listings to check for changes, the idle source doing it and
+-- whether the cache must be written back
+local refresh_queue = {}
+local refresh_source = nil
+local dirty = false
+
+local stamp = function(path)
+    local info = Gio.File.new_for_path(path):query_info("time::modified,time::modified-usec",
+                                                        Gio.FileQueryInfoFlags.NONE)
+    if not info then
+        return false
+    end
+    return string.format("%d.%06d",
+                         info:get_attribute_uint64("time::modified"),
+                         info:get_attribute_uint32("time::modified-usec"))
+end
+
+local scan = function(path)
+    -- Get the stamp first, so that a change during the scan is caught by the
+    -- next refresh.
+    local listing = { stamp = stamp(path), files = {} }
+    if listing.stamp then
+        local enum = Gio.File.new_for_path(path):enumerate_children("standard::name",
+                                                                    Gio.FileQueryInfoFlags.NONE)
+        if enum then
+            while true do
+                local info = enum:next_file()
+                if not info then
+                    break
+                end
+                listing.files[info:get_name()] = true
+            end
+            enum:close()
+        end
+    end
+    return listing
+end
+
+local save_cache = function()
+    dirty = false
+    local filename = icon_theme.cache_file
+    if not filename then
+        return
+    end
+
+    local dir = filename:match("(.*)/")
+    if dir then
+        -- Fails if the directory already exists, which is fine.
+        pcall(function() Gio.File.new_for_path(dir):make_directory_with_parents() end)
+    end
+
+    local tmp = filename .. ".tmp"
+    local f = io.open(tmp, "w")
+    if not f then
+        return
+    end
+    f:write(CACHE_VERSION, "\n")
+    for path, listing in pairs(listings) do
+        f:write("D\t", path, "\t", listing.stamp or "-", "\n")
+        for name in pairs(listing.files) do
+            f:write("F\t", name, "\n")
+        end
+    end
+    f:close()
+    os.rename(tmp, filename)
+end
+
+local refresh_step = function()
+    for _ = 1, REFRESH_BATCH do
+        local path = table.remove(refresh_queue)
+        if not path then
+            refresh_source = nil
+            if dirty then
+                save_cache()
+            end
+            return false
+        end
+        local listing = listings[path]
+        if listing and stamp(path) ~= listing.stamp then
+            listings[path] = scan(path)
+            generation = generation + 1
+            dirty = true
+        end
+    end
+    return true
+end
+
+local schedule_refresh = function()
+    if not refresh_source then
+        refresh_source = GLib.idle_add(GLib.PRIORITY_LOW, refresh_step)
+    end
+end
+
+--- Check the cached icon directories for changes.
+-- This happens in the background, a few directories per main loop iteration.
+-- Changed directories are scanned again and the on-disk cache is updated.
+-- The cache is checked once after it is loaded; call this function when the
+-- installed icon themes changed since then.
+function icon_theme.refresh_cache()
+    if not listings then
+        return
+    end
+    refresh_queue = {}
+    for path in pairs(listings) do
+        table.insert(refresh_queue, path)
+    end
+    schedule_refresh()
+end
+
+local load_cache = function()
+    listings = {}
+    local f = icon_theme.cache_file and io.open(icon_theme.cache_file, "r")
+    if not f then
+        return
+    end
+    if f:read("*l") == CACHE_VERSION then
+        local files
+        for line in f:lines() do
+            local name = line:match("^F\t(.*)$")
+            if name then
+                if files then
+                    files[name] = true
+                end
+            else
+                local path, st = line:match("^D\t(.*)\t([^\t]*)$")
+                if path then
+                    files = {}
+                    listings[path] = { stamp = st ~= "-" and st, files = files }
+                end
+            end
+        end
+    end
+    f:close()
+    icon_theme.refresh_cache()
+end
+
+local get_listing = function(path)
+    if not listings then
+        load_cache()
+    end
+    local listing = listings[path]
+    if not listing then
+        listing = scan(path)
+        listings[path] = listing
+        dirty = true
+        schedule_refresh()
+    end
+    return listing
+end
+
+-- Map the icon names found in a listing to the set of their extensions.
+local get_listing_icons = function(listing)
+    if not listing.icons then
+        listing.icons = {}
+        for file in pairs(listing.files) do
+            local name, ext = file:match("^(.+)%.([^.]+)$")
+            if name then
+                listing.icons[name] = listing.icons[name] or {}
+                listing.icons[name][ext] = true
+            end
+        end
+    end
+    return listing.icons
+end
+
+local instances = {}
 
 --- Class constructor of `icon_theme`
+-- Instances are shared between calls with the same arguments.
 -- @tparam string icon_theme_name Internal name of icon theme
 -- @tparam table base_directories Paths used for lookup
 -- @treturn table An instance of the class `icon_theme`
@@ -85,24 +274,73 @@ icon_theme.new = function(icon_theme_name, base_directories)
     icon_theme_name = icon_theme_name or beautiful.icon_theme or get_default_icon_theme_name()
     base_directories = base_directories or get_pragmatic_base_directories()
 
+    if not instances[icon_theme_name] then
+        instances[icon_theme_name] = {}
+    end
+    local cache_key = table.concat(base_directories, ':')
+    if instances[icon_theme_name][cache_key] then
+        return instances[icon_theme_name][cache_key]
+    end
+
     local self = {}
     self.icon_theme_name = icon_theme_name
     self.base_directories = base_directories
     self.extensions = { "png", "svg", "xpm" }
+    self.index_theme = index_theme(self.icon_theme_name, self.base_directories)
+
+    instances[icon_theme_name][cache_key] = self
+    return setmetatable(self, { __index = icon_theme })
+end
+
+-- Map icon names to the files of this theme, as a list of subdirectories and
+-- paths in lookup order.
+local get_icons = function(self)
+    if self.icons and self.icons_generation == generation then
+        return self.icons
+    end
 
-    -- Instantiate index_theme (cached).
-    if not index_theme_cache[self.icon_theme_name] then
-        index_theme_cache[self.icon_theme_name] = {}
+    local icons = {}
+    for _, basedir in ipairs(self.base_directories) do
+        local theme_dir = basedir .. "/" .. self.icon_theme_name
+        local theme_listing = get_listing(theme_dir)
+        for subdir_pos, subdir in ipairs(self.index_theme:get_subdirectories()) do
+            -- Only look into subdirectories whose top level exists.
+            if theme_listing.files[subdir:match("^[^/]+")] then
+                local dir = theme_dir .. "/" .. subdir
+                for name, exts in pairs(get_listing_icons(get_listing(dir))) do
+                    for _, ext in ipairs(self.extensions) do
+                        if exts[ext] then
+                            icons[name] = icons[name] or {}
+                            table.insert(icons[name], {
+                                subdir_pos = subdir_pos,
+                                subdir = subdir,
+                                path = string.format("%s/%s.%s", dir, name, ext),
+                            })
+                        end
+                    end
+                end
+            end
+        end
     end
-    local cache_key = table.concat(self.base_directories, ':')
-    if not index_theme_cache[self.icon_theme_name][cache_key] then
-        index_theme_cache[self.icon_theme_name][cache_key] = index_theme(
-            self.icon_theme_name,
-            self.base_directories)
+
+    -- Subdirectories come first, then base directories, then extensions.
+    -- The sort is stable because the subdirectory is the only key and
+    -- entries of the same subdirectory were inserted in order.
+    for _, files in pairs(icons) do
+        for i = 2, #files do
+            local file = files[i]
+            local j = i - 1
+            while j > 0 and files[j].subdir_pos > file.subdir_pos do
+                files[j + 1] = files[j]
+                j = j - 1
+            end
+            files[j + 1] = file
+        end
     end
-    self.index_theme = index_theme_cache[self.icon_theme_name][cache_key]
 
-    return setmetatable(self, { __index = icon_theme })
+    self.icons = icons
+    self.icons_generation = generation
+    return icons
 end
 
 local directory_matches_size = function(self, subdirectory, icon_size)
@@ -144,42 +382,24 @@ local directory_size_distance = function(self, subdirectory, icon_size)
 end
 
 local lookup_icon = function(self, icon_name, icon_size)
-    local checked_already = {}
-    for _, subdir in ipairs(self.index_theme:get_subdirectories()) do
-        for _, basedir in ipairs(self.base_directories) do
-            for _, ext in ipairs(self.extensions) do
-                if directory_matches_size(self, subdir, icon_size) then
-                    local filename = string.format("%s/%s/%s/%s.%s",
-                                                   basedir, self.icon_theme_name, subdir,
-                                                   icon_name, ext)
-                    if awful_util.file_readable(filename) then
-                        return filename
-                    else
-                        checked_already[filename] = true
-                    end
-                end
-            end
+    local files = get_icons(self)[icon_name]
+    if not files then
+        return nil
+    end
+
+    for _, file in ipairs(files) do
+        if directory_matches_size(self, file.subdir, icon_size) then
+            return file.path
         end
     end
 
     local minimal_size = 0xffffffff -- Any large number will do.
     local closest_filename = nil
-    for _, subdir in ipairs(self.index_theme:get_subdirectories()) do
-        local dist = directory_size_distance(self, subdir, icon_size)
+    for _, file in ipairs(files) do
+        local dist = directory_size_distance(self, file.subdir, icon_size)
         if dist < minimal_size then
-            for _, basedir in ipairs(self.base_directories) do
-                for _, ext in ipairs(self.extensions) do
-                    local filename = string.format("%s/%s/%s/%s.%s",
-                                                   basedir, self.icon_theme_name, subdir,
-                                                   icon_name, ext)
-                    if not checked_already[filename] then
-                        if awful_util.file_readable(filename) then
-                            closest_filename = filename
-                            minimal_size = dist
-                        end
-                    end
-                end
-            end
+            closest_filename = file.path
+            minimal_size = dist
         end
     end
     return closest_filename
@@ -205,12 +425,12 @@ end
 
 local lookup_fallback_icon = function(self, icon_name)
     for _, dir in ipairs(self.base_directories) do
-        for _, ext in ipairs(self.extensions) do
-            local filename = string.format("%s/%s.%s",
-                                           dir,
-                                           icon_name, ext)
-            if awful_util.file_readable(filename) then
-                return filename
+        local exts = get_listing_icons(get_listing(dir))[icon_name]
+        if exts then
+            for _, ext in ipairs(self.extensions) do
+                if exts[ext] then
+                    return string.format("%s/%s.%s", dir, icon_name, ext)
+                end
             end
         end
     end
@@ -38,6 +38,7 @@ end
 local menubar = { mt = {}, menu_entries = {} }
 menubar.menu_gen = require("menubar.menu_gen")
 menubar.utils = require("menubar.utils")
+menubar.search = require("menubar.search")
 local compute_text_width = menubar.utils.compute_text_width
 
 -- Options section
@@ -93,6 +94,9 @@ local current_item = 1
 local previous_item = nil
 local current_category = nil
 local shownitems = nil
+local exec_item = nil
+local focused_item = nil
+local entries_index = nil
 local instance = nil
 
 local common_args = { w = wibox.layout.fixed.horizontal(),
@@ -147,6 +151,26 @@ local function write_count_table(count_table)
     count_file:close()
 end
 
+--- Get a displayed item.
+-- The matching entries are sorted lazily, so only the ones that are looked at
+-- get sorted. The item to execute the query comes last.
+-- @tparam number i The position of the item.
+-- @return The item, or nil.
+local function get_item(i)
+    local count = shownitems:len()
+    if i <= count then
+        return shownitems:get(i)
+    elseif i == count + 1 then
+        return exec_item
+    end
+end
+
+--- Get the number of displayed items.
+-- @treturn number The number of items.
+local function get_item_count()
+    return shownitems:len() + 1
+end
+
 --- Perform an action for the given menu item.
 -- @param o The menu item.
 -- @return if the function processed the callback, new awful.prompt command, new awful.prompt prompt text.
@@ -154,16 +178,16 @@ local function perform_action(o)
     if not o then return end
     if o.key then
         current_category = o.key
-        local new_prompt = shownitems[current_item].name .. ": "
+        local new_prompt = o.name .. ": "
         previous_item = current_item
         current_item = 1
         return true, "", new_prompt
-    elseif shownitems[current_item].cmdline then
-        awful.spawn(shownitems[current_item].cmdline)
+    elseif o.cmdline then
+        awful.spawn(o.cmdline)
         -- load count_table from cache file
         local count_table = load_count_table()
         -- increase count
-        local curname = shownitems[current_item].name
+        local curname = o.name
         count_table[curname] = (count_table[curname] or 0) + 1
         -- write updated count table to cache file
         write_count_table(count_table)
@@ -174,11 +198,11 @@ local function perform_action(o)
 end
 
 -- Cut item list to return only current page.
--- @tparam table all_items All items list.
+-- Only the items up to the end of the current page are looked at.
 -- @tparam str query Search query.
 -- @tparam number|screen scr Screen
 -- @return table List of items for current page.
-local function get_current_page(all_items, query, scr)
+local function get_current_page(query, scr)
     scr = get_screen(scr)
     if not instance.prompt.width then
         instance.prompt.width = compute_text_width(instance.prompt.prompt, scr)
@@ -195,7 +219,8 @@ local function get_current_page(all_items, query, scr)
 
     local width_sum = 0
     local current_page = {}
-    for i, item in ipairs(all_items) do
+    for i = 1, get_item_count() do
+        local item = get_item(i)
         item.width = item.width or
             compute_text_width(item.name, scr) +
             (item.icon and instance.geometry.height or 0) + list_interspace
@@ -219,115 +244,93 @@ end
 -- @tparam number|screen scr Screen
 local function menulist_update(scr)
     local query = instance.query or ""
-    shownitems = {}
-    local pattern = awful.util.query_to_pattern(query)
 
     -- All entries are added to a list that will be sorted
-    -- according to the priority (first) and weight (second) of its
-    -- entries.
+    -- according to the priority (first), weight (second) and match score
+    -- (third) of its entries.
     -- If categories are used in the menu, we add the entries matching
     -- the current query with high priority as to ensure they are
     -- displayed first. Afterwards the non-category entries are added.
+    -- Prefix matches get a higher priority than the others.
     -- All entries are weighted according to the number of times they
     -- have been executed previously (stored in count_table).
     local count_table = load_count_table()
     local command_list = {}
+    local scores = {}
+    local lquery = string.lower(query)
 
     local PRIO_NONE = 0
     local PRIO_CATEGORY_MATCH = 2
 
+    local function add(v, prio, score, kind)
+        v.weight = 0
+        -- get use count from count_table if present
+        -- and use it as weight
+        if #query > 0 and count_table[v.name] ~= nil then
+            v.weight = tonumber(count_table[v.name])
+        end
+        -- increase default priority for prefix matches
+        v.prio = prio + (kind == menubar.search.match.prefix and 1 or 0)
+        scores[v] = score
+        table.insert(command_list, v)
+    end
+
     -- Add the categories
     if menubar.show_categories then
         for _, v in pairs(menubar.menu_gen.all_categories) do
-            v.focused = false
             if not current_category and v.use then
-
-                -- check if current query matches a category
-                if string.match(v.name, pattern) then
-
-                    v.weight = 0
-                    v.prio = PRIO_CATEGORY_MATCH
-
-                    -- get use count from count_table if present
-                    -- and use it as weight
-                    if string.len(pattern) > 0 and count_table[v.name] ~= nil then
-                        v.weight = tonumber(count_table[v.name])
-                    end
-
-                    -- check for prefix match
-                    if string.match(v.name, "^" .. pattern) then
-                        -- increase default priority
-                        v.prio = PRIO_CATEGORY_MATCH + 1
-                    else
-                        v.prio = PRIO_CATEGORY_MATCH
-                    end
-
-                    table.insert (command_list, v)
+                local score, kind = menubar.search.score(string.lower(v.name), lquery)
+                if score then
+                    add(v, PRIO_CATEGORY_MATCH, score, kind)
                 end
             end
         end
     end
 
     -- Add the applications according to their name and cmdline
-    for _, v in ipairs(menubar.menu_entries) do
-        v.focused = false
+    if not entries_index or entries_index.entries ~= menubar.menu_entries then
+        entries_index = menubar.search.new(menubar.menu_entries)
+    end
+    local matches, entry_scores, kinds = entries_index:query(query)
+    for _, i in ipairs(matches) do
+        local v = menubar.menu_entries[i]
         if not current_category or v.category == current_category then
-
-            -- check if the query matches either the name or the commandline
-            -- of some entry
-            if string.match(v.name, pattern)
-                or string.match(v.cmdline, pattern) then
-
-                v.weight = 0
-                v.prio = PRIO_NONE
-
-                -- get use count from count_table if present
-                -- and use it as weight
-                if string.len(pattern) > 0 and count_table[v.name] ~= nil then
-                    v.weight = tonumber(count_table[v.name])
-                end
-
-                -- check for prefix match
-                if string.match(v.name, "^" .. pattern)
-                    or string.match(v.cmdline, "^" .. pattern) then
-                    -- increase default priority
-                    v.prio = PRIO_NONE + 1
-                else
-                    v.prio = PRIO_NONE
-                end
-
-                table.insert (command_list, v)
-            end
+            add(v, PRIO_NONE, entry_scores[i], kinds[i])
         end
     end
 
     local function compare_counts(a, b)
-        if a.prio == b.prio then
+        if a.prio ~= b.prio then
+            return a.prio > b.prio
+        end
+        if a.weight ~= b.weight then
             return a.weight > b.weight
         end
-        return a.prio > b.prio
+        return scores[a] > scores[b]
     end
 
-    -- sort command_list by weight (highest first)
-    table.sort(command_list, compare_counts)
-    -- copy into showitems
-    shownitems = command_list
+    -- sort command_list by weight (highest first), lazily
+    shownitems = menubar.search.sorted(command_list, compare_counts)
 
-    if #shownitems > 0 then
-        -- Insert a run item value as the last choice
-        table.insert(shownitems, { name = "Exec: " .. query, cmdline = query, icon = nil })
-
-        if current_item > #shownitems then
-            current_item = #shownitems
-        end
-        shownitems[current_item].focused = true
+    if shownitems:len() > 0 then
+        -- Add a run item value as the last choice
+        exec_item = { name = "Exec: " .. query, cmdline = query, icon = nil }
     else
-        table.insert(shownitems, { name = "", cmdline = query, icon = nil })
+        exec_item = { name = "", cmdline = query, icon = nil }
+    end
+
+    if current_item > get_item_count() then
+        current_item = get_item_count()
+    end
+    if focused_item then
+        focused_item.focused = false
     end
+    focused_item = get_item(current_item)
+    focused_item.focused = true
 
     common.list_update(common_args.w, nil, label,
                        common_args.data,
-                       get_current_page(shownitems, query, scr))
+                       get_current_page(query, scr))
 end
 
 --- Refresh menubar's cache by reloading .desktop files.
@@ -335,6 +338,7 @@ end
 function menubar.refresh(scr)
     menubar.menu_gen.generate(function(entries)
         menubar.menu_entries = entries
+        entries_index = menubar.search.new(entries)
         if instance then
             menulist_update(scr)
         end
@@ -369,18 +373,18 @@ local function prompt_keypressed_callback(mod, key, comm)
         current_item = 1
         return true
     elseif key == "End" then
-        current_item = #shownitems
+        current_item = get_item_count()
         return true
     elseif key == "Return" or key == "KP_Enter" then
         if mod.Control then
-            current_item = #shownitems
+            current_item = get_item_count()
             if mod.Mod1 then
                 -- add a terminal to the cmdline
-                shownitems[current_item].cmdline = menubar.utils.terminal
-                        .. " -e " .. shownitems[current_item].cmdline
+                exec_item.cmdline = menubar.utils.terminal
+                        .. " -e " .. exec_item.cmdline
             end
         end
-        return perform_action(shownitems[current_item])
+        return perform_action(get_item(current_item))
     end
     return false
 end
@@ -0,0 +1,237 @@
+---------------------------------------------------------------------------
+--- Incremental fuzzy search for menubar entries.
+--
+-- A query matches an entry if all its characters appear in that order in one
+-- of the entry's fields, ignoring case. Matches are scored by their kind:
+-- prefix matches first, then matches at the start of a word, then other
+-- substrings and finally scattered characters, the closer the better.
+--
+-- An index is built once for a list of entries. It maps each character to the
+-- entries containing it, so that only the entries containing the rarest
+-- character of a query get scored. The results of the previous queries are
+-- kept, so that extending a query only filters the results of the shorter
+-- one, and removing characters again is free.
+--
+-- @module menubar.search
+---------------------------------------------------------------------------
+
+local ipairs = ipairs
+local setmetatable = setmetatable
+local string = string
+local math = math
+
+local search = {}
+
+--- Kinds of matches, from the worst to the best.
+-- @table match
+search.match = {
+    fuzzy = 1,
+    substring = 2,
+    word = 3,
+    prefix = 4,
+}
+
+-- Scores of different kinds never overlap, the rest only orders matches of
+-- the same kind
+local KIND_FACTOR = 65536
+
+local function lower(s)
+    return s and string.lower(s) or ""
+end
+
+--- Score how well a query matches a string.
+-- @tparam string key The string, in lower case.
+-- @tparam string query The query, in lower case.
+-- @treturn number|nil The score, higher is better, or nil if there is no
+--   match.
+-- @treturn number|nil The kind of match, see `match`.
+function search.score(key, query)
+    if query == "" then
+        return search.match.prefix * KIND_FACTOR, search.match.prefix
+    end
+
+    local first = key:find(query, 1, true)
+    if first == 1 then
+        return search.match.prefix * KIND_FACTOR, search.match.prefix
+    elseif first then
+        local pos = first
+        while pos do
+            if not key:sub(pos - 1, pos - 1):match("%w") then
+                return search.match.word * KIND_FACTOR - pos, search.match.word
+            end
+            pos = key:find(query, pos + 1, true)
+        end
+        return search.match.substring * KIND_FACTOR - first, search.match.substring
+    end
+
+    -- Look for the characters one after the other, counting the gaps
+    local pos, gaps = 0, 0
+    for i = 1, #query do
+        local found = key:find(query:sub(i, i), pos + 1, true)
+        if not found then return nil end
+        if i > 1 then
+            gaps = gaps + found - pos - 1
+        end
+        pos = found
+    end
+    return search.match.fuzzy * KIND_FACTOR - math.min(gaps, KIND_FACTOR - 1), search.match.fuzzy
+end
+
+local index = {}
+
+--- Get the entries that might match a query.
+-- @tparam string query The query, in lower case.
+-- @treturn table The positions of the entries, in ascending order.
+function index:candidates(query)
+    if query == "" then
+        local all = {}
+        for i = 1, #self.entries do
+            all[i] = i
+        end
+        return all
+    end
+
+    local best
+    for i = 1, #query do
+        local list = self.chars[query:sub(i, i)]
+        if not list then return {} end
+        if not best or #list < #best then
+            best = list
+        end
+    end
+    return best
+end
+
+--- Search the entries.
+-- @tparam string query The query.
+-- @treturn table The positions of the matching entries, in ascending order.
+-- @treturn table The score of each matching entry, by position.
+-- @treturn table The kind of match of each matching entry, by position.
+function index:query(query)
+    query = lower(query)
+
+    -- Drop the results of the queries this one doesn't extend
+    local history = self.history
+    local top = history[#history]
+    while top and query:sub(1, #top.query) ~= top.query do
+        history[#history] = nil
+        top = history[#history]
+    end
+    if top and top.query == query then
+        return top.matches, top.scores, top.kinds
+    end
+
+    local candidates = top and top.matches or self:candidates(query)
+    local matches, scores, kinds = {}, {}, {}
+    for _, i in ipairs(candidates) do
+        local best, best_kind
+        for _, key in ipairs(self.keys[i]) do
+            local score, kind = search.score(key, query)
+            if score and (not best or score > best) then
+                best, best_kind = score, kind
+            end
+        end
+        if best then
+            matches[#matches + 1] = i
+            scores[i] = best
+            kinds[i] = best_kind
+        end
+    end
+
+    history[#history + 1] = { query = query, matches = matches, scores = scores, kinds = kinds }
+    return matches, scores, kinds
+end
+
+--- Build a search index.
+-- @tparam table entries The entries to search.
+-- @tparam[opt={"name","cmdline"}] table fields The fields of the entries to
+--   search in.
+-- @return The index.
+function search.new(entries, fields)
+    fields = fields or { "name", "cmdline" }
+
+    local ret = setmetatable({
+        entries = entries,
+        keys = {},
+        chars = {},
+        history = {},
+    }, { __index = index })
+
+    for i, entry in ipairs(entries) do
+        local keys, seen = {}, {}
+        for j, field in ipairs(fields) do
+            local key = lower(entry[field])
+            keys[j] = key
+            for c in key:gmatch(".") do
+                if not seen[c] then
+                    seen[c] = true
+                    local list = ret.chars[c]
+                    if not list then
+                        list = {}
+                        ret.chars[c] = list
+                    end
+                    list[#list + 1] = i
+                end
+            end
+        end
+        ret.keys[i] = keys
+    end
+
+    return ret
+end
+
+local sorted = {}
+
+--- Get the number of items.
+-- @treturn number The number of items.
+function sorted:len()
+    return #self.done + #self.heap
+end
+
+local function sift_down(heap, i, cmp)
+    local n = #heap
+    while true do
+        local best = i
+        local left, right = 2 * i, 2 * i + 1
+        if left <= n and cmp(heap[left], heap[best]) then
+            best = left
+        end
+        if right <= n and cmp(heap[right], heap[best]) then
+            best = right
+        end
+        if best == i then return end
+        heap[i], heap[best] = heap[best], heap[i]
+        i = best
+    end
+end
+
+--- Get an item, sorting only as far as needed.
+-- @tparam number i The position of the item.
+-- @return The item, or nil.
+function sorted:get(i)
+    local done, heap = self.done, self.heap
+    while #done < i and #heap > 0 do
+        done[#done + 1] = heap[1]
+        heap[1] = heap[#heap]
+        heap[#heap] = nil
+        sift_down(heap, 1, self.cmp)
+    end
+    return done[i]
+end
+
+--- Sort a list lazily.
+-- Getting the first items of the result only costs a partial sort, so that
+-- only the items that get displayed are put in order.
+-- @tparam table items The items, the table is reused.
+-- @tparam function cmp The comparison function, as for `table.sort`.
+-- @return An object with `get(i)` and `len()` methods.
+function search.sorted(items, cmp)
+    for i = math.floor(#items / 2), 1, -1 do
+        sift_down(items, i, cmp)
+    end
+    return setmetatable({ heap = items, done = {}, cmp = cmp }, { __index = sorted })
+end
+
+return search
+
+-- vim: filetype=lua:expandtab:shiftwidth=4:tabstop=8:softtabstop=4:textwidth=80
@@ -10,6 +10,7 @@
 local io = io
 local table = table
 local ipairs = ipairs
+local pairs = pairs
 local string = string
 local screen = screen
 local awful_util = require("awful.util")
@@ -162,11 +163,11 @@ function utils.lookup_icon(icon)
     return lookup_icon_cache[icon] or default_icon
 end
 
---- Parse a .desktop file.
+-- Read the [Desktop Entry] group of a .desktop file.
 -- @param file The .desktop file.
--- @return A table with file entries.
-function utils.parse_desktop_file(file)
-    local program = { show = true, file = file }
+-- @return A table with the keys of the group, or nil if there is none.
+local function read_desktop_entry(file)
+    local entry = {}
     local desktop_entry = false
 
     -- Parse the .desktop file.
@@ -185,13 +186,23 @@ function utils.parse_desktop_file(file)
 
             -- Grab the values
             for key, value in line:gmatch("(%w+)%s*=%s*(.+)") do
-                program[key] = value
+                entry[key] = value
             end
         end
     end
 
-    -- In case [Desktop Entry] was not found
-    if not desktop_entry then return nil end
+    return desktop_entry and entry or nil
+end
+
+-- Turn the [Desktop Entry] group of a .desktop file into a menu entry.
+-- @param file The .desktop file.
+-- @param entry The keys of the group, as returned by `read_desktop_entry`.
+-- @return A table with file entries.
+local function desktop_entry_to_program(file, entry)
+    local program = { show = true, file = file }
+    for key, value in pairs(entry) do
+        program[key] = value
+    end
 
     -- In case the (required) 'Name' entry was not found
     if not program.Name or program.Name == '' then return nil end
@@ -244,20 +255,120 @@ function utils.parse_desktop_file(file)
     return program
 end
 
+--- Parse a .desktop file.
+-- @param file The .desktop file.
+-- @return A table with file entries.
+function utils.parse_desktop_file(file)
+    local entry = read_desktop_entry(file)
+    return entry and desktop_entry_to_program(file, entry)
+end
+
+--- Path of the file caching the parsed .desktop files.
+-- Set it to `false` before the first call to `parse_dir` to disable the
+-- on-disk cache.
+utils.desktop_cache_file = awful_util.get_cache_dir() .. "desktop_entries"
+
+local DESKTOP_CACHE_VERSION = "desktop entries cache 1"
+
+-- The [Desktop Entry] groups of the .desktop files seen so far, by path,
+-- with the modification time of the file they were read from. A group is
+-- false for files without one.
+local desktop_cache = nil
+local desktop_cache_save = nil
+
+local function load_desktop_cache()
+    desktop_cache = {}
+    local f = utils.desktop_cache_file and io.open(utils.desktop_cache_file, "r")
+    if not f then
+        return
+    end
+    if f:read("*l") == DESKTOP_CACHE_VERSION then
+        local entry
+        for line in f:lines() do
+            local key, value = line:match("^K\t(%w+)\t(.*)$")
+            if key then
+                if entry then
+                    entry[key] = value
+                end
+            else
+                local kind, path, stamp = line:match("^([EN])\t(.*)\t([^\t]*)$")
+                if kind then
+                    entry = kind == "E" and {}
+                    desktop_cache[path] = { stamp = stamp, entry = entry or false }
+                end
+            end
+        end
+    end
+    f:close()
+end
+
+local function save_desktop_cache()
+    desktop_cache_save = nil
+    local filename = utils.desktop_cache_file
+    if not filename then
+        return false
+    end
+
+    local dir = filename:match("(.*)/")
+    if dir then
+        -- Fails if the directory already exists, which is fine.
+        pcall(function() gio.File.new_for_path(dir):make_directory_with_parents() end)
+    end
+
+    local tmp = filename .. ".tmp"
+    local f = io.open(tmp, "w")
+    if not f then
+        return false
+    end
+    f:write(DESKTOP_CACHE_VERSION, "\n")
+    for path, cached in pairs(desktop_cache) do
+        f:write(cached.entry and "E\t" or "N\t", path, "\t", cached.stamp, "\n")
+        for key, value in pairs(cached.entry or {}) do
+            f:write("K\t", key, "\t", value, "\n")
+        end
+    end
+    f:close()
+    os.rename(tmp, filename)
+    return false
+end
+
+-- Write the cache once the current batch of work is done.
+local function schedule_desktop_cache_save()
+    if not desktop_cache_save then
+        desktop_cache_save = glib.idle_add(glib.PRIORITY_LOW, save_desktop_cache)
+    end
+end
+
+local function file_stamp(info)
+    return string.format("%d.%06d",
+                         info:get_attribute_uint64(gio.FILE_ATTRIBUTE_TIME_MODIFIED),
+                         info:get_attribute_uint32(gio.FILE_ATTRIBUTE_TIME_MODIFIED_USEC))
+end
+
 --- Parse a directory with .desktop files recursively.
+-- The contents of the files are cached, also on disk (see
+-- `desktop_cache_file`), so that only new and modified files are read again.
 -- @tparam string dir_path The directory path.
 -- @tparam function callback Will be fired when all the files were parsed
 -- with the resulting list of menu entries as argument.
 -- @tparam table callback.programs Paths of found .desktop files.
 function utils.parse_dir(dir_path, callback)
+    if not desktop_cache then
+        load_desktop_cache()
+    end
+    local seen = {}
+    local changed = false
+    local complete = true
 
     local function parser(dir, programs)
         local f = gio.File.new_for_path(dir)
         -- Except for "NONE" there is also NOFOLLOW_SYMLINKS
-        local query = gio.FILE_ATTRIBUTE_STANDARD_NAME .. "," .. gio.FILE_ATTRIBUTE_STANDARD_TYPE
+        local query = gio.FILE_ATTRIBUTE_STANDARD_NAME .. "," .. gio.FILE_ATTRIBUTE_STANDARD_TYPE ..
+            "," .. gio.FILE_ATTRIBUTE_TIME_MODIFIED .. "," .. gio.FILE_ATTRIBUTE_TIME_MODIFIED_USEC
         local enum, err = f:async_enumerate_children(query, gio.FileQueryInfoFlags.NONE)
         if not enum then
             debug.print_error(err)
+            complete = false
             return
         end
         local files_per_call = 100 -- Actual value is not that important
@@ -265,13 +376,22 @@ function utils.parse_dir(dir_path, callback)
             local list, enum_err = enum:async_next_files(files_per_call)
             if enum_err then
                 debug.print_error(enum_err)
+                complete = false
                 return
             end
             for _, info in ipairs(list) do
                 local file_type = info:get_file_type()
                 local file_path = enum:get_child(info):get_path()
                 if file_type == 'REGULAR' then
-                    local program = utils.parse_desktop_file(file_path)
+                    local stamp = file_stamp(info)
+                    local cached = desktop_cache[file_path]
+                    if not cached or cached.stamp ~= stamp then
+                        cached = { stamp = stamp, entry = read_desktop_entry(file_path) or false }
+                        desktop_cache[file_path] = cached
+                        changed = true
+                    end
+                    seen[file_path] = true
+                    local program = cached.entry and desktop_entry_to_program(file_path, cached.entry)
                     if program then
                         table.insert(programs, program)
                     end
@@ -289,6 +409,21 @@ function utils.parse_dir(dir_path, callback)
     gio.Async.start(function()
         local result = {}
         parser(dir_path, result)
+
+        -- Forget about the files which were removed.
+        if complete then
+            local prefix = dir_path:gsub("/*$", "/")
+            for path in pairs(desktop_cache) do
+                if not seen[path] and path:sub(1, #prefix) == prefix then
+                    desktop_cache[path] = nil
+                    changed = true
+                end
+            end
+        end
+        if changed then
+            schedule_desktop_cache_save()
+        end
+
         protected_call.call(callback, result)
     end)()
 end
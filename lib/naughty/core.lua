@@ -8,6 +8,7 @@
 
 -- Package environment
 local pairs = pairs
+local ipairs = ipairs
 local table = table
 local type = type
 local string = string
@@ -22,6 +23,7 @@ local bt = require("beautiful")
 local wibox = require("wibox")
 local surface = require("gears.surface")
 local cairo = require("lgi").cairo
+local GLib = require("lgi").GLib
 local dpi = bt.xresources.apply_dpi
 
 local function get_screen(s)
@@ -41,6 +43,12 @@ Naughty configuration - a table containing common popup settings.
   that will be checked by `getIcon()`.
 @tfield[opt={ "png", "gif" }] table icon_formats List of formats that will be
   checked by `getIcon()`.
+@tfield[opt=8] int pool_size Number of popups of destroyed notifications kept
+  around to display the next ones, instead of creating new popups.
+@tfield[opt=0] int burst_limit Number of notifications an application can
+  display within `burst_interval` seconds. The next ones update its last
+  notification instead of opening new popups. 0 disables the limit.
+@tfield[opt=1] number burst_interval Length of a burst, in seconds.
 @tfield[opt] function notify_callback Callback used to modify or reject
 notifications, e.g.
     naughty.config.notify_callback = function(args)
@@ -60,6 +68,9 @@ naughty.config = {
     spacing = dpi(1),
     icon_dirs = { "/usr/share/pixmaps/", },
     icon_formats = { "png", "gif" },
+    pool_size = 8,
+    burst_limit = 0,
+    burst_interval = 1,
     notify_callback = nil,
 }
 
@@ -174,6 +185,18 @@ local counter = 1
 -- True if notifying is suspended
 local suspended = false
 
+-- Popups and layout state of the live notifications, by notification
+local private = setmetatable({}, { __mode = "k" })
+
+-- Total height of the notifications of each list, spacing included
+local list_heights = setmetatable({}, { __mode = "k" })
+
+-- Popups of destroyed notifications, ready to be reused
+local popup_pool = {}
+
+-- Start, count and last notification of the current burst of each application
+local bursts = {}
+
 --- Index of notifications per screen and position.
 -- See config table for valid 'position' values.
 -- Each element is a table consisting of:
@@ -235,21 +258,20 @@ function naughty.toggle()
     end
 end
 
---- Evaluate desired position of the notification by index - internal
+--- Evaluate desired position of a notification - internal
 --
 -- @param s Screen to use
 -- @param position top_right | top_left | bottom_right | bottom_left
 --   | top_middle | bottom_middle
--- @param idx Index of the notification
--- @param[opt] width Popup width.
+-- @param existing Total height of the preceding notifications, spacing
+--   included
+-- @param width Popup width
 -- @param height Popup height
--- @return Absolute position and index in { x = X, y = Y, idx = I } table
-local function get_offset(s, position, idx, width, height)
+-- @return Absolute position in { x = X, y = Y } table
+local function get_offset(s, position, existing, width, height)
     s = get_screen(s)
     local ws = s.workarea
     local v = {}
-    idx = idx or #naughty.notifications[s][position] + 1
-    width = width or naughty.notifications[s][position][idx].width
 
     -- calculate x
     if position:match("left") then
@@ -260,12 +282,6 @@ local function get_offset(s, position, idx, width, height)
         v.x = ws.x + ws.width - (width + naughty.config.padding)
     end
 
-    -- calculate existing popups' height
-    local existing = 0
-    for i = 1, idx-1, 1 do
-        existing = existing + naughty.notifications[s][position][i].height + naughty.config.spacing
-    end
-
     -- calculate y
     if position:match("top") then
         v.y = ws.y + naughty.config.padding + existing
@@ -273,42 +289,109 @@ local function get_offset(s, position, idx, width, height)
         v.y = ws.y + ws.height - (naughty.config.padding + height + existing)
     end
 
-    -- Find old notification to replace in case there is not enough room.
-    -- This tries to skip permanent notifications (without a timeout),
-    -- e.g. critical ones.
-    local find_old_to_replace = function()
-        for i = 1, idx-1 do
-            local n = naughty.notifications[s][position][i]
-            if n.timeout > 0 then
-                return n
-            end
-        end
-        -- Fallback to first one.
-        return naughty.notifications[s][position][1]
+    return v
+end
+
+--- Re-arrange notifications of a position from an index on - internal
+--
+-- Only the notifications after a removed one move, so the preceding ones keep
+-- their place and their running offset.
+-- @param s Screen of the notifications
+-- @param position Position of the notifications
+-- @param from Index of the first notification to move
+-- @return None
+local function arrange(s, position, from)
+    local list = naughty.notifications[s][position]
+    local existing = 0
+
+    if from > 1 then
+        local previous = list[from - 1]
+        existing = private[previous].existing + previous.height + naughty.config.spacing
     end
 
-    -- if positioned outside workarea, destroy oldest popup and recalculate
-    if v.y + height > ws.y + ws.height or v.y < ws.y then
-        naughty.destroy(find_old_to_replace())
-        idx = idx - 1
-        v = get_offset(s, position, idx, width, height)
+    for i = from, #list do
+        local notification = list[i]
+        local offset = get_offset(s, position, existing, notification.width, notification.height)
+        notification.box:geometry({ x = offset.x, y = offset.y })
+        notification.idx = i
+        private[notification].existing = existing
+        existing = existing + notification.height + naughty.config.spacing
     end
-    if not v.idx then v.idx = idx end
 
-    return v
+    list_heights[list] = existing
 end
 
---- Re-arrange notifications according to their position and index - internal
+--- Get a popup to display a notification - internal
 --
+-- The popup of a destroyed notification is reused if there is one, with its
+-- drawin and widgets.
+-- @return A table with the box and its widgets
+local function get_popup()
+    local popup = table.remove(popup_pool)
+    if popup then return popup end
+
+    popup = {
+        box            = wibox({ type = "notification" }),
+        textbox        = wibox.widget.textbox(),
+        marginbox      = wibox.container.margin(),
+        iconbox        = wibox.widget.imagebox(),
+        iconmargin     = wibox.container.margin(),
+        layout         = wibox.layout.fixed.horizontal(),
+        actionslayout  = wibox.layout.fixed.vertical(),
+        completelayout = wibox.layout.fixed.vertical(),
+    }
+    popup.textbox:set_valign("middle")
+    popup.marginbox:set_widget(popup.textbox)
+    popup.iconbox:set_resize(false)
+    popup.iconmargin:set_widget(popup.iconbox)
+    popup.completelayout:add(popup.layout)
+    popup.completelayout:add(popup.actionslayout)
+    popup.box:set_widget(popup.completelayout)
+
+    return popup
+end
+
+--- Hide the popup of a destroyed notification and keep it for reuse - internal
+--
+-- @param popup The popup
 -- @return None
-local function arrange(s)
-    for p in pairs(naughty.notifications[s]) do
-        for i,notification in pairs(naughty.notifications[s][p]) do
-            local offset = get_offset(s, p, i, notification.width, notification.height)
-            notification.box:geometry({ x = offset.x, y = offset.y })
-            notification.idx = offset.idx
-        end
+local function release_popup(popup)
+    popup.box.visible = false
+    if popup.hover_destroy then
+        popup.box:disconnect_signal("mouse::enter", popup.hover_destroy)
+        popup.hover_destroy = nil
+    end
+
+    if #popup_pool >= (naughty.config.pool_size or 0) then return end
+
+    popup.layout:buttons({})
+    popup.layout:reset()
+    popup.actionslayout:reset()
+    popup.iconbox:set_image(nil)
+    table.insert(popup_pool, popup)
+end
+
+--- Find the notification an application's burst should be merged into - internal
+--
+-- @param appname Name of the application sending the notification
+-- @return The burst, and its last notification if the new one should update
+--   it instead of opening a new popup
+local function get_burst(appname)
+    local limit = naughty.config.burst_limit or 0
+    if not appname or limit <= 0 then return end
+
+    local now = GLib.get_monotonic_time() / 1000000
+    local burst = bursts[appname]
+    if not burst or now - burst.start > (naughty.config.burst_interval or 1) then
+        burst = { start = now, count = 0 }
+        bursts[appname] = burst
+    end
+    burst.count = burst.count + 1
+
+    if burst.count > limit and burst.last and private[burst.last] then
+        return burst, burst.last
     end
+    return burst
 end
 
 --- Destroy notification by notification object
@@ -317,7 +400,8 @@ end
 -- @param reason One of the reasons from notificationClosedReason
 -- @return True if the popup was successfully destroyed, nil otherwise
 function naughty.destroy(notification, reason)
-    if notification and notification.box.visible then
+    local priv = notification and private[notification]
+    if priv then
         if suspended then
             for k, v in pairs(naughty.notifications.suspended) do
                 if v.box == notification.box then
@@ -331,8 +415,13 @@ function naughty.destroy(notification, reason)
         if notification.timer then
             notification.timer:stop()
         end
-        notification.box.visible = false
-        arrange(scr)
+        private[notification] = nil
+        release_popup(priv.popup)
+        -- The popup now belongs to the pool, do not let the destroyed
+        -- notification update it behind the back of the next one.
+        notification.box = nil
+        notification.textbox = nil
+        arrange(scr, notification.position, notification.idx)
         if notification.destroy_cb and reason ~= naughty.notificationClosedReason.silent then
             notification.destroy_cb(reason or naughty.notificationClosedReason.undefined)
         end
@@ -399,6 +488,7 @@ local function set_text(notification, title, text)
     local escape_subs = { ['<'] = "&lt;", ['>'] = "&gt;", ['&'] = "&amp;" }
 
     local textbox = notification.textbox
+    if not textbox then return end
 
     local function setMarkup(pattern, replacements)
         return textbox:set_markup_silently(string.format('<b>%s</b>%s', title, text:gsub(pattern, replacements)))
@@ -426,8 +516,10 @@ end
 -- @tparam notification notification Notification object, which contents are to be replaced.
 -- @tparam string new_title New title of notification. If not specified, old title remains unchanged.
 -- @tparam string new_text New text of notification. If not specified, old text remains unchanged.
--- @return None.
+-- @return None. Nothing happens if the notification was already destroyed.
 function naughty.replace_text(notification, new_title, new_text)
+    if not private[notification] then return end
+
     local title = new_title
 
     if title then title = title .. "\n" else title = "" end
@@ -529,6 +621,20 @@ function naughty.notify(args)
         beautiful.notification_opacity
     local notification = { screen = s, destroy_cb = destroy_cb, timeout = timeout }
 
+    -- merge bursts from the same application into their last notification
+    local burst, last
+    if not args.replaces_id then
+        burst, last = get_burst(args.appname)
+    end
+    if last then
+        local merged = burst.count - naughty.config.burst_limit
+        naughty.replace_text(last, (title and title .. " " or "") .. "(+" .. merged .. ")", text)
+        if last.timer then
+            naughty.reset_timeout(last)
+        end
+        return last
+    end
+
     -- replace notification if needed
     if args.replaces_id then
         local obj = naughty.getById(args.replaces_id)
@@ -576,19 +682,17 @@ function naughty.notify(args)
         end
     end
 
-    -- create textbox
-    local textbox = wibox.widget.textbox()
-    local marginbox = wibox.container.margin()
-    marginbox:set_margins(margin)
-    marginbox:set_widget(textbox)
-    textbox:set_valign("middle")
+    -- get a popup, possibly one of a destroyed notification
+    local popup = get_popup()
+    local textbox = popup.textbox
+    popup.marginbox:set_margins(margin)
     textbox:set_font(font)
 
     notification.textbox = textbox
 
     set_text(notification, title, text)
 
-    local actionslayout = wibox.layout.fixed.vertical()
+    local actionslayout = popup.actionslayout
     local actions_max_width = 0
     local actions_total_height = 0
     if actions then
@@ -618,7 +722,7 @@ function naughty.notify(args)
         end
     end
 
-    -- create iconbox
+    -- set up the iconbox
     local iconbox = nil
     local iconmargin = nil
     local icon_w, icon_h = 0, 0
@@ -639,8 +743,9 @@ function naughty.notify(args)
 
         -- if we have an icon, use it
         if icon then
-            iconbox = wibox.widget.imagebox()
-            iconmargin = wibox.container.margin(iconbox, margin, margin, margin, margin)
+            iconbox = popup.iconbox
+            iconmargin = popup.iconmargin
+            iconmargin:set_margins(margin)
             if icon_size then
                 local scaled = cairo.ImageSurface(cairo.Format.ARGB32, icon_size, icon_size)
                 local cr = cairo.Context(scaled)
@@ -649,24 +754,24 @@ function naughty.notify(args)
                 cr:paint()
                 icon = scaled
             end
-            iconbox:set_resize(false)
             iconbox:set_image(icon)
             icon_w = icon:get_width()
             icon_h = icon:get_height()
         end
     end
 
-    -- create container wibox
-    notification.box = wibox({ fg = fg,
-                               bg = bg,
-                               border_color = border_color,
-                               border_width = border_width,
-                               shape_border_color = shape and border_color,
-                               shape_border_width = shape and border_width,
-                               shape = shape,
-                               type = "notification" })
-
-    if hover_timeout then notification.box:connect_signal("mouse::enter", hover_destroy) end
+    -- style the container wibox
+    notification.box = popup.box
+    notification.box.fg = fg
+    notification.box.bg = bg
+    notification.box.border_color = border_color
+    notification.box.border_width = border_width or 0
+    notification.box.shape = shape
+
+    if hover_timeout then
+        popup.hover_destroy = hover_destroy
+        notification.box:connect_signal("mouse::enter", hover_destroy)
+    end
 
     -- calculate the width
     if not width then
@@ -704,8 +809,27 @@ function naughty.notify(args)
     notification.height = height + 2 * (border_width or 0)
     notification.width = width + 2 * (border_width or 0)
 
+    -- make room for the new popup, dropping the oldest ones
+    local list = naughty.notifications[s][notification.position]
+    local ws = s.workarea
+    local existing = list_heights[list] or 0
+    local offset = get_offset(s, notification.position, existing, notification.width, notification.height)
+    while #list > 0 and (offset.y + notification.height > ws.y + ws.height or offset.y < ws.y) do
+        -- This tries to skip permanent notifications (without a timeout),
+        -- e.g. critical ones, and falls back to the oldest one.
+        local old = list[1]
+        for _, n in ipairs(list) do
+            if n.timeout > 0 then
+                old = n
+                break
+            end
+        end
+        naughty.destroy(old)
+        existing = list_heights[list] or 0
+        offset = get_offset(s, notification.position, existing, notification.width, notification.height)
+    end
+
     -- position the wibox
-    local offset = get_offset(s, notification.position, nil, notification.width, notification.height)
     notification.box.ontop = ontop
     notification.box:geometry({ width = width,
                                 height = height,
@@ -713,19 +837,14 @@ function naughty.notify(args)
                                 y = offset.y })
     notification.box.opacity = opacity
     notification.box.visible = true
-    notification.idx = offset.idx
+    notification.idx = #list + 1
 
     -- populate widgets
-    local layout = wibox.layout.fixed.horizontal()
+    local layout = popup.layout
     if iconmargin then
         layout:add(iconmargin)
     end
-    layout:add(marginbox)
-
-    local completelayout = wibox.layout.fixed.vertical()
-    completelayout:add(layout)
-    completelayout:add(actionslayout)
-    notification.box:set_widget(completelayout)
+    layout:add(popup.marginbox)
 
     -- Setup the mouse events
     layout:buttons(util.table.join(button({}, 1, nil, run),
@@ -734,7 +853,12 @@ function naughty.notify(args)
                                     end)))
 
     -- insert the notification to the table
-    table.insert(naughty.notifications[s][notification.position], notification)
+    table.insert(list, notification)
+    private[notification] = { popup = popup, existing = existing }
+    list_heights[list] = existing + notification.height + naughty.config.spacing
+    if burst then
+        burst.last = notification
+    end
 
     if suspended then
         notification.box.visible = false
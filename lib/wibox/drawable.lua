@@ -18,27 +18,36 @@ local color = require("gears.color")
 local object = require("gears.object")
 local surface = require("gears.surface")
 local timer = require("gears.timer")
-local grect =  require("gears.geometry").rectangle
 local matrix = require("gears.matrix")
 local hierarchy = require("wibox.hierarchy")
+local protected_call = require("gears.protected_call")
 local unpack = unpack or table.unpack -- luacheck: globals unpack (compatibility with Lua 5.1)
 
 local visible_drawables = {}
 
+-- Drawables waiting for a repaint, in the order they asked for it
+local pending_redraws = {}
+
+-- Used for emptying a region without creating a new one
+local empty_rectangle = cairo.RectangleInt{ x = 0, y = 0, width = 0, height = 0 }
+
 -- Get the widget context. This should always return the same table (if
 -- possible), so that our draw and fit caches can work efficiently.
 local function get_widget_context(self)
-    local geom = self.drawable:geometry()
-
     local s = self._forced_screen
     if not s then
-        local sgeos = {}
+        -- This runs on every redraw, so avoid creating geometry tables
+        local x, y = self.drawable:unpacked_geometry()
 
         for scr in capi.screen do
-            sgeos[scr] = scr.geometry
+            local sx, sy, sw, sh = scr:unpacked_geometry()
+            if x >= sx and x < sx + sw and y >= sy and y < sy + sh then
+                s = scr
+                break
+            end
         end
 
-        s = grect.get_by_coord(sgeos, geom.x, geom.y) or capi.screen.primary
+        s = s or capi.screen.primary
     end
 
     local context = self._widget_context
@@ -60,21 +69,43 @@ local function get_widget_context(self)
     return context
 end
 
-local function do_redraw(self)
+-- Get the cairo context for drawing to a drawable's surface. It is kept
+-- until the surface changes.
+local function get_cairo_context(self)
+    local cr = self._cr
+    if not cr then
+        local surf = surface.load_silently(self.drawable.surface, false)
+        -- The surface can be nil if the drawable's parent was already finalized
+        if not surf then return end
+        cr = cairo.Context(surf)
+        self._cr = cr
+    end
+    return cr
+end
+
+-- Get the wallpaper for pseudo-transparency, loading it once per batch of
+-- repaints
+local function get_wallpaper(batch)
+    if not batch.wallpaper_loaded then
+        batch.wallpaper_loaded = true
+        batch.wallpaper = surface.load_silently(capi.root.wallpaper(), false)
+    end
+    return batch.wallpaper
+end
+
+local function do_redraw(self, batch)
     if not self.drawable.valid then return end
     if self._forced_screen and not self._forced_screen.valid then return end
 
-    local surf = surface.load_silently(self.drawable.surface, false)
-    -- The surface can be nil if the drawable's parent was already finalized
-    if not surf then return end
-    local cr = cairo.Context(surf)
-    local geom = self.drawable:geometry();
-    local x, y, width, height = geom.x, geom.y, geom.width, geom.height
+    local cr = get_cairo_context(self)
+    if not cr then return end
+    local x, y, width, height = self.drawable:unpacked_geometry()
     local context = get_widget_context(self)
 
     -- Relayout
     if self._need_relayout or self._need_complete_repaint then
         self._need_relayout = false
+        self._hit_index = nil
         if self._widget_hierarchy and self.widget then
             self._widget_hierarchy:update(context,
                 self.widget, width, height, self._dirty_area)
@@ -101,11 +132,14 @@ local function do_redraw(self)
     if self._dirty_area:is_empty() then
         return
     end
+    -- The context is only kept if drawing completes and restores its state
+    self._cr = nil
+    cr:save()
     for i = 0, self._dirty_area:num_rectangles() - 1 do
         local rect = self._dirty_area:get_rectangle(i)
         cr:rectangle(rect.x, rect.y, rect.width, rect.height)
     end
-    self._dirty_area = cairo.Region.create()
+    self._dirty_area:intersect_rectangle(empty_rectangle)
     cr:clip()
 
     -- Draw the background
@@ -113,7 +147,7 @@ local function do_redraw(self)
 
     if not capi.awesome.composite_manager_running then
         -- This is pseudo-transparency: We draw the wallpaper in the background
-        local wallpaper = surface.load_silently(capi.root.wallpaper(), false)
+        local wallpaper = get_wallpaper(batch)
         cr.operator = cairo.Operator.SOURCE
         if wallpaper then
             cr:set_source_surface(wallpaper, -x, -y)
@@ -151,42 +185,119 @@ local function do_redraw(self)
         self._widget_hierarchy:draw(context, cr)
     end
 
+    cr:restore()
     self.drawable:refresh()
 
     assert(cr.status == "SUCCESS", "Cairo context entered error state: " .. cr.status)
+    self._cr = cr
 end
 
-local function find_widgets(_drawable, result, _hierarchy, x, y)
-    local m = _hierarchy:get_matrix_from_device()
-
-    -- Is (x,y) inside of this hierarchy or any child (aka the draw extents)
-    local x1, y1 = m:transform_point(x, y)
-    local x2, y2, w2, h2 = _hierarchy:get_draw_extents()
-    if x1 < x2 or x1 >= x2 + w2 then
-        return
-    end
-    if y1 < y2 or y1 >= y2 + h2 then
-        return
+-- Repaint all drawables that asked for it since the last time. Hidden
+-- drawables are skipped, they get a complete repaint when they are shown
+-- again, see drawable:_inform_visible(). The X server gets the result with
+-- the flush at the end of the main loop iteration.
+local function redraw_pending()
+    local list = pending_redraws
+    pending_redraws = {}
+    local batch = {}
+    for _, d in ipairs(list) do
+        if d._redraw_pending then
+            d._redraw_pending = false
+            if d._visible ~= false then
+                protected_call(do_redraw, d, batch)
+            end
+        end
     end
+end
 
-    -- Is (x,y) inside of this widget?
+-- Flatten a hierarchy into a list in drawing order. Each entry knows the
+-- device-space bounding box of its hierarchy's draw extents and the position
+-- after its last descendant, so that a query can skip whole subtrees. The
+-- result table of each widget is created here once and handed out by all
+-- queries until the next relayout.
+local function build_hit_index(_drawable, index, _hierarchy)
+    local m = _hierarchy:get_matrix_to_device()
     local width, height = _hierarchy:get_size()
-    if x1 >= 0 and y1 >= 0 and x1 <= width and y1 <= height then
-        -- Get the extents of this widget in the device space
-        local x3, y3, w3, h3 = matrix.transform_rectangle(_hierarchy:get_matrix_to_device(),
-            0, 0, width, height)
-        table.insert(result, {
-            x = x3, y = y3, width = w3, height = h3,
+    local x, y, w, h = matrix.transform_rectangle(m, 0, 0, width, height)
+    local ext_x, ext_y, ext_w, ext_h = matrix.transform_rectangle(m, _hierarchy:get_draw_extents())
+
+    local entry = {
+        -- Without rotation or mirroring, the device-space boxes are exact
+        aligned = m.xy == 0 and m.yx == 0 and m.xx > 0 and m.yy > 0,
+        ext_x1 = ext_x, ext_y1 = ext_y,
+        ext_x2 = ext_x + ext_w, ext_y2 = ext_y + ext_h,
+        result = {
+            x = x, y = y, width = w, height = h,
             widget_width = width,
             widget_height = height,
             drawable = _drawable,
             widget = _hierarchy:get_widget(),
             hierarchy = _hierarchy
-        })
+        }
+    }
+    if not entry.aligned then
+        entry.from_device = _hierarchy:get_matrix_from_device()
     end
+
+    table.insert(index, entry)
     for _, child in ipairs(_hierarchy:get_children()) do
-        find_widgets(_drawable, result, child, x, y)
+        build_hit_index(_drawable, index, child)
     end
+    entry.next = #index + 1
+end
+
+local function get_hit_index(_drawable)
+    local index = _drawable._hit_index
+    if not index then
+        index = {}
+        if _drawable._widget_hierarchy then
+            build_hit_index(_drawable, index, _drawable._widget_hierarchy)
+        end
+        _drawable._hit_index = index
+    end
+    return index
+end
+
+-- Fill result with the widgets under a point and return it
+local function find_widgets(_drawable, result, x, y)
+    local index = get_hit_index(_drawable)
+    local count, i = 0, 1
+    while index[i] do
+        local entry = index[i]
+        local res = entry.result
+
+        -- Is (x,y) inside of this hierarchy or any child (aka the draw extents)
+        local inside_extents, inside_widget = false, false
+        if x >= entry.ext_x1 and x < entry.ext_x2 and y >= entry.ext_y1 and y < entry.ext_y2 then
+            if entry.aligned then
+                inside_extents = true
+                inside_widget = x >= res.x and y >= res.y and
+                    x <= res.x + res.width and y <= res.y + res.height
+            else
+                -- The box is only an approximation, check in widget space
+                local x1, y1 = entry.from_device:transform_point(x, y)
+                local x2, y2, w2, h2 = res.hierarchy:get_draw_extents()
+                inside_extents = x1 >= x2 and x1 < x2 + w2 and y1 >= y2 and y1 < y2 + h2
+                inside_widget = inside_extents and x1 >= 0 and y1 >= 0 and
+                    x1 <= res.widget_width and y1 <= res.widget_height
+            end
+        end
+
+        if inside_extents then
+            if inside_widget then
+                count = count + 1
+                result[count] = res
+            end
+            i = i + 1
+        else
+            i = entry.next
+        end
+    end
+
+    for j = #result, count + 1, -1 do
+        result[j] = nil
+    end
+    return result
 end
 
 --- Find a widget by a point.
@@ -200,13 +311,11 @@ end
 -- `.hierarchy`. For convenience, `.x`, `.y`, `.width` and `.height` contain an
 -- approximation of the widget's extents on the surface. `widget_width` and
 -- `widget_height` contain the exact size of the widget in its own, local
--- coordinate system (which may e.g. be rotated and scaled).
+-- coordinate system (which may e.g. be rotated and scaled). The entries are
+-- shared between calls until the widgets are laid out again and must not be
+-- modified.
 function drawable:find_widgets(x, y)
-    local result = {}
-    if self._widget_hierarchy then
-        find_widgets(self, result, self._widget_hierarchy, x, y)
-    end
-    return result
+    return find_widgets(self, {}, x, y)
 end
 
 
@@ -216,6 +325,7 @@ function drawable:set_widget(widget)
 
     -- Make sure the widget gets drawn
     self._need_relayout = true
+    self._hit_index = nil
     self.draw()
 end
 
@@ -285,6 +395,7 @@ function drawable:_force_screen(s)
 end
 
 function drawable:_inform_visible(visible)
+    if self._visible == visible then return end
     self._visible = visible
     if visible then
         visible_drawables[self] = true
@@ -295,6 +406,15 @@ function drawable:_inform_visible(visible)
     end
 end
 
+-- Repaint right away instead of at the end of the main loop iteration, if a
+-- repaint is pending and the drawable is visible
+function drawable:_redraw_now()
+    if self._redraw_pending and self._visible ~= false then
+        self._redraw_pending = false
+        protected_call(do_redraw, self, {})
+    end
+end
+
 local function emit_difference(name, list, skip)
     local function in_table(table, val)
         for _, v in pairs(table) do
@@ -318,19 +438,23 @@ local function handle_leave(_drawable)
 end
 
 local function handle_motion(_drawable, x, y)
-    if x < 0 or y < 0 or x > _drawable.drawable:geometry().width or y > _drawable.drawable:geometry().height then
+    local _, _, width, height = _drawable.drawable:unpacked_geometry()
+    if x < 0 or y < 0 or x > width or y > height then
         return handle_leave(_drawable)
     end
 
-    -- Build a plain list of all widgets on that point
-    local widgets_list = _drawable:find_widgets(x, y)
+    -- Build a plain list of all widgets on that point. The list from the
+    -- motion before the previous one is no longer used and gets refilled.
+    local widgets_list = find_widgets(_drawable, _drawable._widgets_spare or {}, x, y)
+    local previous = _drawable._widgets_under_mouse
 
     -- First, "leave" all widgets that were left
-    emit_difference("mouse::leave", _drawable._widgets_under_mouse, widgets_list)
+    emit_difference("mouse::leave", previous, widgets_list)
     -- Then enter some widgets
-    emit_difference("mouse::enter", widgets_list, _drawable._widgets_under_mouse)
+    emit_difference("mouse::enter", widgets_list, previous)
 
     _drawable._widgets_under_mouse = widgets_list
+    _drawable._widgets_spare = previous
 end
 
 local function setup_signals(_drawable)
@@ -369,17 +493,17 @@ function drawable.new(d, widget_context_skeleton, drawable_name)
         end
     end
 
-    -- Only redraw a drawable once, even when we get told to do so multiple times.
+    -- Only redraw a drawable once, even when we get told to do so multiple
+    -- times. All drawables are repainted together, see redraw_pending().
     ret._redraw_pending = false
-    ret._do_redraw = function()
-        ret._redraw_pending = false
-        do_redraw(ret)
-    end
 
     -- Connect our signal when we need a redraw
     ret.draw = function()
         if not ret._redraw_pending then
-            timer.delayed_call(ret._do_redraw)
+            if #pending_redraws == 0 then
+                timer.delayed_call(redraw_pending)
+            end
+            table.insert(pending_redraws, ret)
             ret._redraw_pending = true
         end
     end
@@ -388,7 +512,14 @@ function drawable.new(d, widget_context_skeleton, drawable_name)
         ret:draw()
     end
 
-    -- Do a full redraw if the surface changes (the new surface has no content yet)
+    -- Do a full redraw if the surface changes (the new surface has no content
+    -- yet). A resize to an empty size drops the surface without a new one.
+    local function drop_cairo_context()
+        ret._cr = nil
+    end
+    d:connect_signal("property::surface", drop_cairo_context)
+    d:connect_signal("property::width", drop_cairo_context)
+    d:connect_signal("property::height", drop_cairo_context)
     d:connect_signal("property::surface", ret._do_complete_repaint)
 
     -- Do a normal redraw when the drawable moves. This will likely do nothing
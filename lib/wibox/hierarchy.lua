@@ -16,6 +16,17 @@ local no_parent = base.no_parent_I_know_what_I_am_doing
 
 local hierarchy = {}
 
+-- Hierarchies that currently have a cached surface, and its size in bytes
+local cached_surfaces = setmetatable({}, { __mode = "k" })
+
+-- Note that a hierarchy and all its parents have to be redrawn
+local function invalidate(h)
+    while h do
+        h._generation = h._generation + 1
+        h = h._parent
+    end
+end
+
 local function hierarchy_new(redraw_callback, layout_callback, callback_arg)
     local result = {
         _matrix = matrix.identity,
@@ -37,10 +48,13 @@ local function hierarchy_new(redraw_callback, layout_callback, callback_arg)
             height = 0
         },
         _parent = nil,
-        _children = {}
+        _children = {},
+        _generation = 0,
+        _cache = nil
     }
 
     function result._redraw()
+        invalidate(result)
         redraw_callback(result, callback_arg)
     end
     function result._layout()
@@ -49,6 +63,7 @@ local function hierarchy_new(redraw_callback, layout_callback, callback_arg)
             h._need_update = true
             h = h._parent
         end
+        invalidate(result)
         layout_callback(result, callback_arg)
     end
     function result._emit_recursive(widget, name, ...)
@@ -82,6 +97,7 @@ function hierarchy_update(self, context, widget, width, height, region, matrix_t
     end
 
     self._need_update = false
+    self._generation = self._generation + 1
 
     local old_x, old_y, old_width, old_height
     local old_widget = self._widget
@@ -266,6 +282,107 @@ local function empty_clip(cr)
     return width == 0 or height == 0
 end
 
+-- Draw a widget and its children, in the hierarchy's coordinate space.
+local function draw_content(self, context, cr, widget)
+    local function call(func, extra_arg1, extra_arg2)
+        if not func then return end
+        if not extra_arg2 then
+            protected_call(func, widget, context, cr, self:get_size())
+        else
+            protected_call(func, widget, context, extra_arg1, extra_arg2, cr, self:get_size())
+        end
+    end
+
+    -- Draw the widget
+    cr:save()
+    cr:rectangle(0, 0, self:get_size())
+    cr:clip()
+    call(widget.draw)
+    cr:restore()
+
+    -- Draw its children (We already clipped to the draw extents above)
+    call(widget.before_draw_children)
+    for i, wi in ipairs(self:get_children()) do
+        call(widget.before_draw_child, i, wi:get_widget())
+        wi:draw(context, cr)
+        call(widget.after_draw_child, i, wi:get_widget())
+    end
+    call(widget.after_draw_children)
+end
+
+local function drop_cache(self)
+    self._cache = nil
+    cached_surfaces[self] = nil
+end
+
+-- Get a surface with the content of a cached hierarchy, drawing it if the
+-- hierarchy changed since it was last drawn. The cache is only used when the
+-- hierarchy is placed at whole pixels without scaling and the inherited
+-- source is a solid colour, so that the result is the same as drawing
+-- directly.
+local function get_cached_surface(self, context, parent_cr)
+    local m = self._matrix_to_device
+    if m.xx ~= 1 or m.yy ~= 1 or m.xy ~= 0 or m.yx ~= 0
+            or m.x0 ~= math.floor(m.x0) or m.y0 ~= math.floor(m.y0) then
+        drop_cache(self)
+        return nil
+    end
+
+    -- Widgets draw with the source they inherit, e.g. a textbox uses the
+    -- foreground colour
+    local source = parent_cr:get_source()
+    if source:get_type() ~= "SOLID" then
+        drop_cache(self)
+        return nil
+    end
+    local _, red, green, blue, alpha = source:get_rgba()
+
+    local ext_x, ext_y, ext_width, ext_height = self:get_draw_extents()
+    local x, y = math.floor(ext_x), math.floor(ext_y)
+    local width, height = math.ceil(ext_x + ext_width) - x, math.ceil(ext_y + ext_height) - y
+    local cache = self._cache
+    if cache and cache.generation == self._generation and cache.x == x and cache.y == y
+            and cache.width == width and cache.height == height
+            and cache.red == red and cache.green == green
+            and cache.blue == blue and cache.alpha == alpha then
+        return cache.surface, x, y
+    end
+
+    if width <= 0 or height <= 0 then
+        drop_cache(self)
+        return nil
+    end
+
+    local surface = cairo.ImageSurface(cairo.Format.ARGB32, width, height)
+    local cr = cairo.Context(surface)
+    cr:translate(-x, -y)
+    cr:set_source_rgba(red, green, blue, alpha)
+    draw_content(self, context, cr, self._widget)
+    surface:flush()
+
+    self._cache = {
+        generation = self._generation,
+        surface = surface,
+        x = x, y = y,
+        width = width, height = height,
+        red = red, green = green, blue = blue, alpha = alpha
+    }
+    cached_surfaces[self] = surface:get_stride() * height
+    return surface, x, y
+end
+
+--- Get the memory used by the surfaces of cached widgets.
+-- @see wibox.widget.base.widget:set_cached
+-- @treturn number The size of all surfaces, in bytes.
+-- @treturn number The number of surfaces.
+function hierarchy.get_cache_usage()
+    local bytes, count = 0, 0
+    for _, size in pairs(cached_surfaces) do
+        bytes, count = bytes + size, count + 1
+    end
+    return bytes, count
+end
+
 --- Draw a hierarchy to some cairo context.
 -- This function draws the widgets in this widget hierarchy to the given cairo
 -- context. The context's clip is used to skip parts that aren't visible.
@@ -287,41 +404,37 @@ function hierarchy:draw(context, cr)
     -- Draw if needed
     if not empty_clip(cr) then
         local opacity = widget:get_opacity()
-        local function call(func, extra_arg1, extra_arg2)
-            if not func then return end
-            if not extra_arg2 then
-                protected_call(func, widget, context, cr, self:get_size())
-            else
-                protected_call(func, widget, context, extra_arg1, extra_arg2, cr, self:get_size())
-            end
-        end
-
-        -- Prepare opacity handling
-        if opacity ~= 1 then
-            cr:push_group()
-        end
+        local surface, x, y
 
-        -- Draw the widget
-        cr:save()
-        cr:rectangle(0, 0, self:get_size())
-        cr:clip()
-        call(widget.draw)
-        cr:restore()
-
-        -- Draw its children (We already clipped to the draw extents above)
-        call(widget.before_draw_children)
-        for i, wi in ipairs(self:get_children()) do
-            call(widget.before_draw_child, i, wi:get_widget())
-            wi:draw(context, cr)
-            call(widget.after_draw_child, i, wi:get_widget())
+        if widget._private.cached then
+            surface, x, y = get_cached_surface(self, context, cr)
+        elseif self._cache then
+            drop_cache(self)
         end
-        call(widget.after_draw_children)
 
-        -- Apply opacity
-        if opacity ~= 1 then
-            cr:pop_group_to_source()
+        if surface then
+            -- Unchanged since the last time, just copy it
+            cr:set_source_surface(surface, x, y)
             cr.operator = cairo.Operator.OVER
-            cr:paint_with_alpha(opacity)
+            if opacity ~= 1 then
+                cr:paint_with_alpha(opacity)
+            else
+                cr:paint()
+            end
+        else
+            -- Prepare opacity handling
+            if opacity ~= 1 then
+                cr:push_group()
+            end
+
+            draw_content(self, context, cr, widget)
+
+            -- Apply opacity
+            if opacity ~= 1 then
+                cr:pop_group_to_source()
+                cr.operator = cairo.Operator.OVER
+                cr:paint_with_alpha(opacity)
+            end
         end
     end
 
@@ -15,6 +15,7 @@ local pairs = pairs
 local type = type
 local object = require("gears.object")
 local grect =  require("gears.geometry").rectangle
+local gshape = require("gears.shape")
 local beautiful = require("beautiful")
 local base = require("wibox.widget.base")
 local cairo = require("lgi").cairo
@@ -75,6 +76,18 @@ function wibox:_apply_shape()
     local geo = self:geometry()
     local bw = self.border_width
 
+    -- Let awesome compute simple shapes itself
+    local native = gshape.native_description(shape, geo.width + 2*bw, geo.height + 2*bw)
+    if native then
+        self.shape_bounding = native
+        -- The clip shape is the same shape without the border
+        native.x, native.y = -bw, -bw
+        native.width, native.height = geo.width + 2*bw, geo.height + 2*bw
+        native.inset = bw
+        self.shape_clip = native
+        return
+    end
+
     -- First handle the bounding shape (things including the border)
     local img = cairo.ImageSurface(cairo.Format.A1, geo.width + 2*bw, geo.height + 2*bw)
     local cr = cairo.Context(img)
@@ -148,7 +161,7 @@ function wibox:set_screen(s)
     self._drawable:_force_screen(s)
 end
 
-for _, k in pairs{ "buttons", "struts", "geometry", "get_xproperty", "set_xproperty" } do
+for _, k in pairs{ "buttons", "struts", "geometry", "unpacked_geometry", "get_xproperty", "set_xproperty" } do
     wibox[k] = function(self, ...)
         return self.drawin[k](self.drawin, ...)
     end
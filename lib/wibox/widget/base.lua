@@ -68,6 +68,34 @@ function base.widget:get_opacity()
     return self._private.opacity
 end
 
+--- Set whether the widget's drawing is cached.
+--
+-- A cached widget is drawn, together with its children, to a surface that is
+-- reused as long as neither it nor one of its children needs a redraw or a
+-- relayout. This saves redrawing complex but mostly static widgets, like
+-- shaped icons or gradient backgrounds, whenever something next to them
+-- changes. Each cached widget keeps a surface of its size in memory, see
+-- `wibox.hierarchy.get_cache_usage`.
+--
+-- The cache is only used where the widget is placed at whole pixels without
+-- scaling or rotation.
+-- @tparam boolean cached Whether the widget should be cached.
+-- @function set_cached
+function base.widget:set_cached(cached)
+    cached = cached and true or false
+    if cached ~= self._private.cached then
+        self._private.cached = cached
+        self:emit_signal("widget::redraw_needed")
+    end
+end
+
+--- Is the widget's drawing cached?
+-- @treturn boolean
+-- @function get_cached
+function base.widget:get_cached()
+    return self._private.cached or false
+end
+
 --- Set the widget's forced width.
 -- @tparam[opt] number width With `nil` the default mechanism of calling the
 --   `:fit` method is used.
@@ -18,9 +18,9 @@
 
 local setmetatable = setmetatable
 local ipairs = ipairs
+local pairs = pairs
 local math = math
-local table = table
-local type = type
+local cairo = require("lgi").cairo
 local color = require("gears.color")
 local base = require("wibox.widget.base")
 local beautiful = require("beautiful")
@@ -109,16 +109,193 @@ local properties = { "width", "height", "border_color", "stack",
                      "max_value", "scale", "min_value", "step_shape",
                      "step_spacing", "step_width" }
 
-function graph.draw(_graph, _, cr, width, height)
-    local max_value = _graph._private.max_value
-    local min_value = _graph._private.min_value or (
-        _graph._private.scale and math.huge or 0)
-    local values = _graph._private.values
+-- The values are kept in ring buffers, so that adding a value to a full graph
+-- doesn't have to move all the others. `first` is the position of the oldest
+-- value in `data`, and `len` the number of values.
+local function new_ring()
+    return { data = {}, first = 1, len = 0, capacity = 0 }
+end
+
+-- Get a value, counting from the newest one, which is 0.
+local function ring_get(ring, i)
+    return ring.data[(ring.first + ring.len - 2 - i) % ring.capacity + 1]
+end
 
+local function ring_push(ring, value, capacity)
+    if capacity ~= ring.capacity then
+        -- Keep the newest values that still fit
+        local data, len = {}, math.max(0, math.min(ring.len, capacity))
+        for i = 1, len do
+            data[i] = ring_get(ring, len - i)
+        end
+        ring.data, ring.first, ring.len, ring.capacity = data, 1, len, capacity
+    end
+    if capacity <= 0 then
+        return
+    end
+    if ring.len < capacity then
+        ring.data[(ring.first + ring.len - 1) % capacity + 1] = value
+        ring.len = ring.len + 1
+    else
+        ring.data[ring.first] = value
+        ring.first = ring.first % capacity + 1
+    end
+end
+
+-- Draw the values of a non-stacked graph, from the `from`th newest to the
+-- `to`th newest one.
+local function draw_values(_graph, cr, from, to, height, min_value, max_value)
+    local values = _graph._private.values
     local step_shape = _graph._private.step_shape
     local step_spacing = _graph._private.step_spacing or 0
     local step_width = _graph._private.step_width or 1
 
+    if values.len == 0 then
+        return
+    end
+
+    cr:save()
+    for i = from, math.min(to, values.len - 1) do
+        local value = ring_get(values, i)
+        if value >= 0 then
+            local x = i*step_width + ((i-1)*step_spacing) + 0.5
+            value = (value - min_value) / max_value
+            cr:move_to(x, height * (1 - value))
+
+            if step_shape then
+                cr:translate(step_width + (i>1 and step_spacing or 0), height * (1 - value))
+                step_shape(cr, step_width, height)
+                cr:translate(0, -(height * (1 - value)))
+            elseif step_width > 1 then
+                cr:rectangle(x, height * (1 - value), step_width, height)
+            else
+                cr:line_to(x, height)
+            end
+        end
+    end
+    cr:set_source(color(_graph._private.color or beautiful.graph_fg or "#ff0000"))
+
+    if step_shape or step_width > 1 then
+        cr:fill()
+    else
+        cr:stroke()
+    end
+    cr:restore()
+end
+
+-- Draw a stacked graph, with a single stroke for each color.
+local function draw_stack(_graph, cr, width, height, max_value)
+    local stack_colors = _graph._private.stack_colors
+    if not stack_colors then
+        return
+    end
+
+    local bases = {}
+    for idx, col in ipairs(stack_colors) do
+        local stack_values = _graph._private.stack_values[idx]
+        if stack_values and stack_values.len > 0 then
+            for i = 0, math.min(width, stack_values.len - 1) do
+                local rel_i = bases[i] or 0
+                local value = ring_get(stack_values, i) + rel_i
+                local rel_x = i + 0.5
+                cr:move_to(rel_x, height * (1 - (rel_i / max_value)))
+                cr:line_to(rel_x, height * (1 - (value / max_value)))
+                bases[i] = value
+            end
+            cr:set_source(color(col or beautiful.graph_fg or "#ff0000"))
+            cr:stroke()
+        end
+    end
+end
+
+-- Get a surface with the values of a non-stacked graph. The surface from the
+-- previous call is reused when possible: if only new values were added, its
+-- content is scrolled and only the new values are drawn.
+local function get_values_surface(_graph, width, height, min_value, max_value)
+    local priv = _graph._private
+    local cache = priv.render_cache
+    local step_spacing = priv.step_spacing or 0
+    local step = (priv.step_width or 1) + step_spacing
+    local pixel_width, pixel_height = math.ceil(width), math.ceil(height)
+    local fg = priv.color or beautiful.graph_fg
+
+    if cache and cache.width == width and cache.height == height and cache.fg == fg
+            and cache.min_value == min_value and cache.max_value == max_value then
+        local new = priv.added - cache.added
+        if new == 0 then
+            return cache.surface
+        end
+
+        -- Scrolling needs whole pixels, and must not keep showing values that
+        -- were dropped from the ring buffer
+        local values = priv.values
+        local shift = new * step
+        if not priv.step_shape and step == math.floor(step) and shift < pixel_width
+                and (values.len < values.capacity
+                     or values.len * step - step_spacing >= pixel_width) then
+            local surface = cache.spare
+            local cr = cairo.Context(surface)
+            cr:set_operator(cairo.Operator.SOURCE)
+            cr:set_source_surface(cache.surface, shift, 0)
+            cr:paint()
+
+            -- Redraw the new values, and the one after them which they can
+            -- overlap
+            cr:rectangle(0, 0, shift + step, pixel_height)
+            cr:clip()
+            cr:set_operator(cairo.Operator.CLEAR)
+            cr:paint()
+            cr:set_operator(cairo.Operator.OVER)
+            cr:set_line_width(1)
+            draw_values(_graph, cr, 0, new + 1, height, min_value, max_value)
+
+            cache.spare, cache.surface = cache.surface, surface
+            cache.added = priv.added
+            return surface
+        end
+    end
+
+    if not cache or cache.width ~= width or cache.height ~= height then
+        cache = {
+            width = width,
+            height = height,
+            surface = cairo.ImageSurface(cairo.Format.ARGB32, pixel_width, pixel_height),
+            spare = cairo.ImageSurface(cairo.Format.ARGB32, pixel_width, pixel_height),
+        }
+        priv.render_cache = cache
+    end
+    cache.min_value, cache.max_value, cache.added = min_value, max_value, priv.added
+    cache.fg = fg
+
+    local cr = cairo.Context(cache.surface)
+    cr:set_operator(cairo.Operator.CLEAR)
+    cr:paint()
+    cr:set_operator(cairo.Operator.OVER)
+    cr:set_line_width(1)
+    draw_values(_graph, cr, 0, priv.values.len - 1, height, min_value, max_value)
+    return cache.surface
+end
+
+-- Surfaces on which an offscreen rendering would be a blurry bitmap
+local vector_surfaces = { PDF = true, PS = true, SVG = true, RECORDING = true, SCRIPT = true }
+
+-- Whether a rendering of the values made at whole pixels can be painted on a
+-- context without changing the result, i.e. the context only translates by
+-- whole pixels and draws to a raster surface.
+local function can_paint_rendering(cr)
+    local m = cr:get_matrix()
+    if m.xx ~= 1 or m.yy ~= 1 or m.xy ~= 0 or m.yx ~= 0
+            or m.x0 ~= math.floor(m.x0) or m.y0 ~= math.floor(m.y0) then
+        return false
+    end
+    return not vector_surfaces[cr:get_target():get_type()]
+end
+
+function graph.draw(_graph, _, cr, width, height)
+    local max_value = _graph._private.max_value
+    local min_value = _graph._private.min_value or (
+        _graph._private.scale and math.huge or 0)
+
     cr:set_line_width(1)
 
     -- Draw the background first
@@ -136,8 +313,9 @@ function graph.draw(_graph, _, cr, width, height)
     if _graph._private.stack then
 
         if _graph._private.scale then
-            for _, v in ipairs(values) do
-                for _, sv in ipairs(v) do
+            for _, v in pairs(_graph._private.stack_values) do
+                for i = 0, v.len - 1 do
+                    local sv = ring_get(v, i)
                     if sv > max_value then
                         max_value = sv
                     end
@@ -148,27 +326,12 @@ function graph.draw(_graph, _, cr, width, height)
             end
         end
 
-        for i = 0, width do
-            local rel_i = 0
-            local rel_x = i + 0.5
-
-            if _graph._private.stack_colors then
-                for idx, col in ipairs(_graph._private.stack_colors) do
-                    local stack_values = values[idx]
-                    if stack_values and i < #stack_values then
-                        local value = stack_values[#stack_values - i] + rel_i
-                        cr:move_to(rel_x, height * (1 - (rel_i / max_value)))
-                        cr:line_to(rel_x, height * (1 - (value / max_value)))
-                        cr:set_source(color(col or beautiful.graph_fg or "#ff0000"))
-                        cr:stroke()
-                        rel_i = value
-                    end
-                end
-            end
-        end
+        draw_stack(_graph, cr, width, height, max_value)
     else
+        local values = _graph._private.values
         if _graph._private.scale then
-            for _, v in ipairs(values) do
+            for i = 0, values.len - 1 do
+                local v = ring_get(values, i)
                 if v > max_value then
                     max_value = v
                 end
@@ -179,32 +342,13 @@ function graph.draw(_graph, _, cr, width, height)
         end
 
         -- Draw the background on no value
-        if #values ~= 0 then
-            -- Draw reverse
-            for i = 0, #values - 1 do
-                local value = values[#values - i]
-                if value >= 0 then
-                    local x = i*step_width + ((i-1)*step_spacing) + 0.5
-                    value = (value - min_value) / max_value
-                    cr:move_to(x, height * (1 - value))
-
-                    if step_shape then
-                        cr:translate(step_width + (i>1 and step_spacing or 0), height * (1 - value))
-                        step_shape(cr, step_width, height)
-                        cr:translate(0, -(height * (1 - value)))
-                    elseif step_width > 1 then
-                        cr:rectangle(x, height * (1 - value), step_width, height)
-                    else
-                        cr:line_to(x, height)
-                    end
-                end
-            end
-            cr:set_source(color(_graph._private.color or beautiful.graph_fg or "#ff0000"))
-
-            if step_shape or step_width > 1 then
-                cr:fill()
+        if values.len ~= 0 and width > 0 and height > 0 then
+            if can_paint_rendering(cr) then
+                cr:set_source_surface(get_values_surface(_graph, width, height, min_value, max_value), 0, 0)
+                cr:paint()
             else
-                cr:stroke()
+                _graph._private.render_cache = nil
+                draw_values(_graph, cr, 0, values.len - 1, height, min_value, max_value)
             end
         end
 
@@ -243,22 +387,20 @@ function graph:add_value(value, group)
     end
 
     if self._private.stack and group then
-        if not  self._private.values[group]
-        or type(self._private.values[group]) ~= "table"
-        then
-            self._private.values[group] = {}
+        values = self._private.stack_values[group]
+        if not values then
+            values = new_ring()
+            self._private.stack_values[group] = values
         end
-        values = self._private.values[group]
+    else
+        self._private.added = self._private.added + 1
     end
-    table.insert(values, value)
 
     local border_width = 0
     if self._private.border_color then border_width = 2 end
 
     -- Ensure we never have more data than we can draw
-    while #values > self._private.width - border_width do
-        table.remove(values, 1)
-    end
+    ring_push(values, value, self._private.width - border_width)
 
     self:emit_signal("widget::redraw_needed")
     return self
@@ -266,7 +408,9 @@ end
 
 --- Clear the graph.
 function graph:clear()
-    self._private.values = {}
+    self._private.values = new_ring()
+    self._private.stack_values = {}
+    self._private.render_cache = nil
     self:emit_signal("widget::redraw_needed")
     return self
 end
@@ -297,6 +441,7 @@ for _, prop in ipairs(properties) do
         graph["set_" .. prop] = function(_graph, value)
             if _graph._private[prop] ~= value then
                 _graph._private[prop] = value
+                _graph._private.render_cache = nil
                 _graph:emit_signal("widget::redraw_needed")
             end
             return _graph
@@ -326,7 +471,9 @@ function graph.new(args)
 
     _graph._private.width     = width
     _graph._private.height    = height
-    _graph._private.values    = {}
+    _graph._private.values    = new_ring()
+    _graph._private.stack_values = {}
+    _graph._private.added     = 0
     _graph._private.max_value = 1
 
     -- Set methods
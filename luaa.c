@@ -127,6 +127,19 @@ extern const struct luaL_Reg awesome_mouse_meta[];
  * @signal xkb::group_changed.
  */
 
+/** The keyboard was grabbed for `keygrabber.run`.
+ *
+ * Key events are only received after this signal.
+ * @signal keygrabber::grab_acquired
+ */
+
+/** The keyboard could not be grabbed for `keygrabber.run`.
+ *
+ * Another client held the keyboard grab for too long. The keygrabber has
+ * already been stopped when this signal is emitted.
+ * @signal keygrabber::grab_failed
+ */
+
 /** Refresh.
  *
  * This signal is emitted as a kind of idle signal in the event loop.
@@ -310,6 +323,26 @@ luaA_set_preferred_icon_size(lua_State *L)
     return 0;
 }
 
+/** Limit the deferred work to one pass per monitor frame.
+ *
+ * By default, the client geometries, the stacking order, the drawins and the
+ * `refresh` signal handlers (which redraw the wiboxes) are processed after each
+ * batch of X events. With frame pacing, that work is done at most once per
+ * frame of the fastest monitor (60 per second if unknown), so bursts of
+ * changes get coalesced. Input events are still handled as they come.
+ *
+ * A warning is printed when the work of a frame exceeds the frame duration.
+ *
+ * @tparam boolean enabled Whether to enable frame pacing.
+ * @function set_frame_pacing
+ */
+static int
+luaA_set_frame_pacing(lua_State *L)
+{
+    globalconf.frame_pacing = luaA_checkboolean(L, 1);
+    return 0;
+}
+
 /** UTF-8 aware string length computing.
  * \param L The Lua VM state.
  * \return The number of elements pushed on stack.
@@ -405,6 +438,11 @@ luaA_fixups(lua_State *L)
  * @tfield string icon_path
  */
 
+/**
+ * The refresh rate of the fastest monitor in Hz, or nil if unknown.
+ * @tfield number refresh_rate
+ */
+
 static int
 luaA_awesome_index(lua_State *L)
 {
@@ -474,6 +512,14 @@ luaA_awesome_index(lua_State *L)
         return 1;
     }
 
+    if(A_STREQ(buf, "refresh_rate"))
+    {
+        if(globalconf.refresh_rate <= 0)
+            return 0;
+        lua_pushnumber(L, globalconf.refresh_rate);
+        return 1;
+    }
+
     return luaA_default_index(L);
 }
 
@@ -765,6 +811,7 @@ luaA_init(xdgHandle* xdg, string_array_t *searchpath)
         { "systray", luaA_systray },
         { "load_image", luaA_load_image },
         { "set_preferred_icon_size", luaA_set_preferred_icon_size },
+        { "set_frame_pacing", luaA_set_frame_pacing },
         { "register_xproperty", luaA_register_xproperty },
         { "set_xproperty", luaA_set_xproperty },
         { "get_xproperty", luaA_get_xproperty },
@@ -259,6 +259,23 @@ luaA_pusharea(lua_State *L, area_t geometry)
     return 1;
 }
 
+/** Push the members of an area as four integers, without creating a table.
+ * This is used by the getters that are called often enough from Lua for the
+ * garbage created by luaA_pusharea() to matter.
+ * \param L The Lua VM state.
+ * \param geometry The area geometry to push.
+ * \return The number of elements pushed on stack.
+ */
+static inline int
+luaA_pusharea_unpacked(lua_State *L, area_t geometry)
+{
+    lua_pushinteger(L, geometry.x);
+    lua_pushinteger(L, geometry.y);
+    lua_pushinteger(L, geometry.width);
+    lua_pushinteger(L, geometry.height);
+    return 4;
+}
+
 /** Register an Lua object.
  * \param L The Lua stack.
  * \param idx Index of the object in the stack.
@@ -304,6 +304,20 @@ luaA_mouse_coords(lua_State *L)
     return luaA_mouse_pushstatus(L, mouse_x, mouse_y, mask);
 }
 
+/* documented in lib/awful/mouse/init.lua */
+static int
+luaA_mouse_unpacked_coords(lua_State *L)
+{
+    int16_t mouse_x, mouse_y;
+
+    if(!mouse_query_pointer_root(&mouse_x, &mouse_y, NULL, NULL))
+        return 0;
+
+    lua_pushinteger(L, mouse_x);
+    lua_pushinteger(L, mouse_y);
+    return 2;
+}
+
 /** Get the client or any object which is under the pointer.
  *
  * @treturn client.object|nil A client or nil.
@@ -353,6 +367,7 @@ const struct luaL_Reg awesome_mouse_methods[] =
     { "__index", luaA_mouse_index },
     { "__newindex", luaA_mouse_newindex },
     { "coords", luaA_mouse_coords },
+    { "unpacked_coords", luaA_mouse_unpacked_coords },
     { "object_under_pointer", luaA_mouse_object_under_pointer },
     { "set_index_miss_handler", luaA_mouse_set_index_miss_handler},
     { "set_newindex_miss_handler", luaA_mouse_set_newindex_miss_handler},
@@ -27,11 +27,49 @@
 
 #include "mousegrabber.h"
 #include "common/xcursor.h"
+#include "common/xutil.h"
 #include "mouse.h"
 #include "globalconf.h"
+#include "objects/client.h"
 
 #include <unistd.h>
 #include <stdbool.h>
+#include <stdlib.h>
+#include <glib.h>
+
+/** Rate at which a native move/resize applies the geometry if the monitors'
+ * refresh rate is unknown */
+#define MOVERESIZE_DEFAULT_FPS 60
+
+DO_ARRAY(area_t, area, DO_NOTHING)
+
+/** State of a native interactive move or resize */
+static struct
+{
+    /** The client being moved or resized, NULL if not running */
+    client_t *client;
+    /** The Lua callback, or LUA_REFNIL */
+    int callback;
+    /** Which edges follow the pointer; all of them for a move */
+    bool left, right, top, bottom;
+    /** Pointer position and client geometry at the start */
+    int16_t start_x, start_y;
+    area_t start_geometry;
+    /** Did we see a button held? The operation ends when all are released */
+    bool buttons_held;
+    /** Snapping distance and the areas whose edges attract the client */
+    int snap;
+    area_array_t snap_areas;
+    /** Minimal time between two geometry changes and two Lua updates, in
+     * microseconds; an update interval of 0 disables the updates */
+    gint64 frame_interval, update_interval;
+    gint64 last_apply, last_update;
+    /** Geometry not applied yet because the last change was too recent */
+    bool pending;
+    area_t pending_geometry;
+    /** Timeout applying the pending geometry, 0 if none */
+    guint source;
+} moveresize = { .callback = LUA_REFNIL };
 
 /** Grab the mouse.
  * \param cursor The cursor to use while grabbing.
@@ -64,6 +102,231 @@ mousegrabber_grab(xcb_cursor_t cursor)
     return false;
 }
 
+/** Compute the offset snapping an edge to the closest snap area edge.
+ * \param edge The coordinate of the edge.
+ * \param horizontal True for a vertical edge, i.e.\ a x coordinate.
+ * \param offset The best offset so far, updated.
+ * \param best The distance of the best offset so far, updated.
+ */
+static void
+mousegrabber_moveresize_snap_edge(int edge, bool horizontal, int *offset, int *best)
+{
+    foreach(area, moveresize.snap_areas)
+    {
+        int edges[2];
+        if(horizontal)
+        {
+            edges[0] = area->x;
+            edges[1] = area->x + area->width;
+        }
+        else
+        {
+            edges[0] = area->y;
+            edges[1] = area->y + area->height;
+        }
+        for(int i = 0; i < countof(edges); i++)
+            if(abs(edges[i] - edge) < *best)
+            {
+                *best = abs(edges[i] - edge);
+                *offset = edges[i] - edge;
+            }
+    }
+}
+
+/** Compute the geometry of the client for a pointer position.
+ * \param x The pointer x coordinate.
+ * \param y The pointer y coordinate.
+ * \return The new geometry.
+ */
+static area_t
+mousegrabber_moveresize_geometry(int x, int y)
+{
+    area_t geo = moveresize.start_geometry;
+    int dx = x - moveresize.start_x, dy = y - moveresize.start_y;
+    int right = geo.x + geo.width, bottom = geo.y + geo.height;
+
+    if(moveresize.left)
+        geo.x += dx;
+    if(moveresize.right)
+        right += dx;
+    if(moveresize.top)
+        geo.y += dy;
+    if(moveresize.bottom)
+        bottom += dy;
+
+    if(moveresize.snap > 0)
+    {
+        int offset = 0, best = moveresize.snap + 1;
+        if(moveresize.left)
+            mousegrabber_moveresize_snap_edge(geo.x, true, &offset, &best);
+        if(moveresize.right)
+            mousegrabber_moveresize_snap_edge(right, true, &offset, &best);
+        /* A move shifts both edges, a resize only the grabbed ones */
+        if(moveresize.left)
+            geo.x += offset;
+        if(moveresize.right)
+            right += offset;
+
+        offset = 0, best = moveresize.snap + 1;
+        if(moveresize.top)
+            mousegrabber_moveresize_snap_edge(geo.y, false, &offset, &best);
+        if(moveresize.bottom)
+            mousegrabber_moveresize_snap_edge(bottom, false, &offset, &best);
+        if(moveresize.top)
+            geo.y += offset;
+        if(moveresize.bottom)
+            bottom += offset;
+    }
+
+    geo.width = MAX(right - geo.x, 1);
+    geo.height = MAX(bottom - geo.y, 1);
+    /* Keep the fixed edge in place when hitting the minimal size */
+    if(moveresize.left && !moveresize.right)
+        geo.x = right - geo.width;
+    if(moveresize.top && !moveresize.bottom)
+        geo.y = bottom - geo.height;
+
+    return geo;
+}
+
+/** Call the Lua callback of a native move/resize.
+ * \param L The Lua VM state.
+ * \param callback The callback reference.
+ * \param c The client.
+ * \param event The event name.
+ */
+static void
+mousegrabber_moveresize_notify(lua_State *L, int callback, client_t *c, const char *event)
+{
+    if(callback == LUA_REFNIL)
+        return;
+    lua_rawgeti(L, LUA_REGISTRYINDEX, callback);
+    luaA_object_push(L, c);
+    lua_pushstring(L, event);
+    luaA_pusharea(L, c->geometry);
+    luaA_dofunction(L, 3, 0);
+}
+
+/** Apply the pending geometry of a native move/resize now.
+ */
+static void
+mousegrabber_moveresize_apply(void)
+{
+    client_t *c = moveresize.client;
+    gint64 now = g_get_monotonic_time();
+
+    if(!moveresize.pending)
+        return;
+    moveresize.pending = false;
+    moveresize.last_apply = now;
+    client_resize(c, moveresize.pending_geometry, c->size_hints_honor);
+
+    if(moveresize.update_interval > 0
+       && now - moveresize.last_update >= moveresize.update_interval)
+    {
+        moveresize.last_update = now;
+        mousegrabber_moveresize_notify(globalconf_get_lua_State(),
+                                       moveresize.callback, c, "update");
+    }
+}
+
+static gboolean
+mousegrabber_moveresize_timeout(gpointer data)
+{
+    moveresize.source = 0;
+    if(moveresize.client && moveresize.client->window != XCB_NONE)
+        mousegrabber_moveresize_apply();
+    return G_SOURCE_REMOVE;
+}
+
+/** End a native move/resize, applying the last geometry.
+ * \param L The Lua VM state.
+ */
+static void
+mousegrabber_moveresize_finish(lua_State *L)
+{
+    client_t *c = moveresize.client;
+    int callback = moveresize.callback;
+
+    if(moveresize.source)
+        g_source_remove(moveresize.source);
+    moveresize.source = 0;
+    if(c->window != XCB_NONE)
+        mousegrabber_moveresize_apply();
+    xcb_ungrab_pointer(globalconf.connection, XCB_CURRENT_TIME);
+
+    /* Reset everything first, the callback may start a new grab */
+    moveresize.client = NULL;
+    moveresize.callback = LUA_REFNIL;
+    area_array_wipe(&moveresize.snap_areas);
+
+    if(c->window != XCB_NONE)
+        mousegrabber_moveresize_notify(L, callback, c, "finish");
+    luaL_unref(L, LUA_REGISTRYINDEX, callback);
+    luaA_object_unref(L, c);
+}
+
+/** Get a snap area from a table.
+ * \param L The Lua VM state.
+ * \param idx The index of the table.
+ * \return The area.
+ */
+static area_t
+mousegrabber_moveresize_getarea(lua_State *L, int idx)
+{
+    area_t area;
+    luaA_checktable(L, idx);
+    area.x = luaA_getopt_integer(L, idx, "x", 0);
+    area.y = luaA_getopt_integer(L, idx, "y", 0);
+    area.width = luaA_getopt_integer(L, idx, "width", 0);
+    area.height = luaA_getopt_integer(L, idx, "height", 0);
+    return area;
+}
+
+/** Handle a pointer event during a native move/resize.
+ * \param x The pointer x coordinate.
+ * \param y The pointer y coordinate.
+ * \param mask The button and modifier mask after the event.
+ * \return False if there is no native move/resize running.
+ */
+bool
+mousegrabber_moveresize_handleevent(int x, int y, uint16_t mask)
+{
+    uint16_t buttons = mask & (XCB_BUTTON_MASK_1 | XCB_BUTTON_MASK_2 | XCB_BUTTON_MASK_3
+                               | XCB_BUTTON_MASK_4 | XCB_BUTTON_MASK_5);
+    gint64 now;
+
+    if(!moveresize.client)
+        return false;
+
+    /* The client went away under our feet */
+    if(moveresize.client->window == XCB_NONE)
+    {
+        mousegrabber_moveresize_finish(globalconf_get_lua_State());
+        return true;
+    }
+
+    moveresize.pending_geometry = mousegrabber_moveresize_geometry(x, y);
+    moveresize.pending = true;
+
+    if(buttons)
+        moveresize.buttons_held = true;
+    else if(moveresize.buttons_held)
+    {
+        mousegrabber_moveresize_finish(globalconf_get_lua_State());
+        return true;
+    }
+
+    now = g_get_monotonic_time();
+    if(now - moveresize.last_apply >= moveresize.frame_interval)
+        mousegrabber_moveresize_apply();
+    else if(!moveresize.source)
+        moveresize.source =
+            g_timeout_add((moveresize.frame_interval - (now - moveresize.last_apply)) / 1000 + 1,
+                          mousegrabber_moveresize_timeout, NULL);
+    return true;
+}
+
 /** Handle mouse motion events.
  * \param L Lua stack to push the pointer motion.
  * \param x The received mouse event x component.
@@ -94,7 +357,7 @@ mousegrabber_handleevent(lua_State *L, int x, int y, uint16_t mask)
 static int
 luaA_mousegrabber_run(lua_State *L)
 {
-    if(globalconf.mousegrabber != LUA_REFNIL)
+    if(globalconf.mousegrabber != LUA_REFNIL || moveresize.client)
         luaL_error(L, "mousegrabber already running");
 
     uint16_t cfont = xcursor_font_fromstr(luaL_checkstring(L, 2));
@@ -117,6 +380,132 @@ luaA_mousegrabber_run(lua_State *L)
     return 0;
 }
 
+/** Interactively move or resize a client from C.
+ * This grabs the pointer like `run`, but the client geometry is computed and
+ * applied without calling Lua for each motion. The geometry changes are
+ * limited to `fps` per second, by default the `awesome.refresh_rate`. The operation ends when all mouse buttons are
+ * released or when `mousegrabber.stop` is called.
+ *
+ * The optional callback is called with the client, an event name and the
+ * client geometry: "start" once the pointer is grabbed, "update" at most
+ * every `update_interval` seconds if it is set, and "finish" at the end.
+ *
+ * @param c The client.
+ * @tparam table args The arguments.
+ * @tparam[opt="move"] string args.mode Either "move" or "resize".
+ * @tparam[opt="bottom_right"] string args.corner The corner or side to drag
+ *   for a resize, e.g. "top_left", "left" or "bottom".
+ * @tparam[opt="fleur"] string args.cursor The name of the X cursor to use.
+ * @tparam[opt=0] integer args.snap The distance at which the client edges
+ *   snap to the edges of `snap_areas`.
+ * @tparam[opt={}] table args.snap_areas A list of geometry tables.
+ * @tparam[opt] number args.fps The maximal geometry update rate.
+ * @tparam[opt] number args.update_interval The interval of the "update"
+ *   callbacks, in seconds.
+ * @tparam[opt] function args.callback The callback.
+ * @function moveresize
+ */
+static int
+luaA_mousegrabber_moveresize(lua_State *L)
+{
+    client_t *c = luaA_checkudata(L, 1, &client_class);
+    const char *mode, *corner, *cursor_name;
+    uint16_t cfont, mask = 0;
+    int16_t x, y;
+    double fps, update_interval;
+
+    if(globalconf.mousegrabber != LUA_REFNIL || moveresize.client)
+        luaL_error(L, "mousegrabber already running");
+
+    luaA_checktable(L, 2);
+    lua_settop(L, 2);
+
+    lua_getfield(L, 2, "mode");
+    mode = luaL_optstring(L, -1, "move");
+    lua_getfield(L, 2, "corner");
+    corner = luaL_optstring(L, -1, "bottom_right");
+    lua_getfield(L, 2, "cursor");
+    cursor_name = luaL_optstring(L, -1, "fleur");
+
+    if(A_STREQ(mode, "move"))
+        moveresize.left = moveresize.right = moveresize.top = moveresize.bottom = true;
+    else if(A_STREQ(mode, "resize"))
+    {
+        moveresize.left = strstr(corner, "left") != NULL;
+        moveresize.right = strstr(corner, "right") != NULL;
+        moveresize.top = strstr(corner, "top") != NULL;
+        moveresize.bottom = strstr(corner, "bottom") != NULL;
+        if(!moveresize.left && !moveresize.right && !moveresize.top && !moveresize.bottom)
+            luaL_error(L, "invalid corner: %s", corner);
+    }
+    else
+        luaL_error(L, "invalid mode: %s", mode);
+
+    cfont = xcursor_font_fromstr(cursor_name);
+    if(!cfont)
+    {
+        luaA_warn(L, "invalid cursor");
+        return 0;
+    }
+
+    moveresize.snap = luaA_getopt_integer_range(L, 2, "snap", 0, 0, MAX_X11_SIZE);
+    fps = luaA_getopt_number_range(L, 2, "fps",
+                                   globalconf.refresh_rate > 0 ? globalconf.refresh_rate : MOVERESIZE_DEFAULT_FPS,
+                                   1, 1000);
+    update_interval = luaA_getopt_number_range(L, 2, "update_interval", 0, 0, G_MAXINT);
+    moveresize.frame_interval = G_USEC_PER_SEC / fps;
+    moveresize.update_interval = update_interval * G_USEC_PER_SEC;
+
+    lua_getfield(L, 2, "snap_areas");
+    if(lua_istable(L, -1))
+    {
+        int len = luaA_rawlen(L, -1);
+        /* Check all areas first, so that an error does not leave some of them
+         * in the array */
+        for(int i = 1; i <= len; i++)
+        {
+            lua_rawgeti(L, -1, i);
+            mousegrabber_moveresize_getarea(L, -1);
+            lua_pop(L, 1);
+        }
+        for(int i = 1; i <= len; i++)
+        {
+            lua_rawgeti(L, -1, i);
+            area_array_append(&moveresize.snap_areas, mousegrabber_moveresize_getarea(L, -1));
+            lua_pop(L, 1);
+        }
+    }
+    lua_pop(L, 1);
+
+    if(!mouse_query_pointer(globalconf.screen->root, &x, &y, NULL, &mask)
+       || !mousegrabber_grab(xcursor_new(globalconf.cursor_ctx, cfont)))
+    {
+        area_array_wipe(&moveresize.snap_areas);
+        luaL_error(L, "unable to grab mouse pointer");
+    }
+
+    lua_getfield(L, 2, "callback");
+    if(lua_isfunction(L, -1))
+        luaA_registerfct(L, -1, &moveresize.callback);
+    else
+        moveresize.callback = LUA_REFNIL;
+    lua_pop(L, 1);
+
+    lua_pushvalue(L, 1);
+    moveresize.client = luaA_object_ref(L, -1);
+    moveresize.start_x = x;
+    moveresize.start_y = y;
+    moveresize.start_geometry = c->geometry;
+    moveresize.buttons_held = (mask & (XCB_BUTTON_MASK_1 | XCB_BUTTON_MASK_2 | XCB_BUTTON_MASK_3
+                                       | XCB_BUTTON_MASK_4 | XCB_BUTTON_MASK_5)) != 0;
+    moveresize.pending = false;
+    moveresize.last_apply = moveresize.last_update = g_get_monotonic_time();
+
+    mousegrabber_moveresize_notify(L, moveresize.callback, c, "start");
+
+    return 0;
+}
+
 /** Stop grabbing the mouse pointer.
  *
  * @function stop
@@ -124,6 +513,11 @@ luaA_mousegrabber_run(lua_State *L)
 int
 luaA_mousegrabber_stop(lua_State *L)
 {
+    if(moveresize.client)
+    {
+        mousegrabber_moveresize_finish(L);
+        return 0;
+    }
     xcb_ungrab_pointer(globalconf.connection, XCB_CURRENT_TIME);
     luaA_unregister(L, &globalconf.mousegrabber);
     return 0;
@@ -137,13 +531,14 @@ luaA_mousegrabber_stop(lua_State *L)
 static int
 luaA_mousegrabber_isrunning(lua_State *L)
 {
-    lua_pushboolean(L, globalconf.mousegrabber != LUA_REFNIL);
+    lua_pushboolean(L, globalconf.mousegrabber != LUA_REFNIL || moveresize.client);
     return 1;
 }
 
 const struct luaL_Reg awesome_mousegrabber_lib[] =
 {
     { "run", luaA_mousegrabber_run },
+    { "moveresize", luaA_mousegrabber_moveresize },
     { "stop", luaA_mousegrabber_stop },
     { "isrunning", luaA_mousegrabber_isrunning },
     { "__index", luaA_default_index },
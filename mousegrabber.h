@@ -24,9 +24,11 @@
 
 #include <lua.h>
 #include <xcb/xcb.h>
+#include <stdbool.h>
 
 int luaA_mousegrabber_stop(lua_State *);
 void mousegrabber_handleevent(lua_State *, int, int, uint16_t);
+bool mousegrabber_moveresize_handleevent(int, int, uint16_t);
 
 #endif
 // vim: filetype=c:expandtab:shiftwidth=4:tabstop=8:softtabstop=4:textwidth=80
@@ -106,6 +106,9 @@
 #include <xcb/shape.h>
 #include <cairo-xcb.h>
 
+/** Time in milliseconds a focused client gets to answer a _NET_WM_PING */
+#define CLIENT_PING_TIMEOUT 5000
+
 /** Client class.
  *
  * @table object
@@ -337,6 +340,38 @@
  * @param number
  */
 
+/**
+ * Whether the client answers `_NET_WM_PING` requests in time.
+ *
+ * The client is pinged when it gets the focus. This is false while the
+ * client appears to be hung, and is always true for clients that do not
+ * support `_NET_WM_PING`.
+ *
+ * A client that did not answer in time is not pinged again until it gets the
+ * focus again. It becomes responsive as soon as it answers the last ping it
+ * was sent, even late.
+ *
+ * **Signal:**
+ *
+ *  * *property::responsive*
+ *
+ * @property responsive
+ * @param boolean
+ */
+
+/**
+ * Whether the client is currently banned, i.e. unmapped because it is not
+ * visible on any selected tag or is minimized or hidden. The banning state is
+ * updated at the end of each main loop iteration.
+ *
+ * **Signal:**
+ *
+ *  * *property::banned*
+ *
+ * @property banned
+ * @param boolean
+ */
+
 /**
  * The window role, if available.
  *
@@ -649,6 +684,10 @@
 /**
  * The client's bounding shape as set by awesome as a (native) cairo surface.
  *
+ * Instead of a surface, a table describing a simple shape can be set. It is
+ * turned into rectangles without drawing it, see
+ * `gears.shape.native_description`.
+ *
  * **Signal:**
  *
  *  * *property::shape\_bounding*
@@ -824,7 +863,8 @@ static void client_set_maximized_common(lua_State *L, int cidx, bool s, const ch
 static void
 client_wipe(client_t *c)
 {
-    key_array_wipe(&c->keys);
+    /* Normally already released by client_unmanage() */
+    key_set_unref(globalconf_get_lua_State(), &c->keys);
     xcb_icccm_get_wm_protocols_reply_wipe(&c->protocols);
     p_delete(&c->machine);
     p_delete(&c->class);
@@ -1047,11 +1087,16 @@ client_ban(client_t *c)
 {
     if(!c->isbanned)
     {
+        lua_State *L = globalconf_get_lua_State();
         xcb_unmap_window(globalconf.connection, c->frame_window);
 
         c->isbanned = true;
 
         client_ban_unfocus(c);
+
+        luaA_object_push(L, c);
+        luaA_object_emit_signal(L, -1, "property::banned", 0);
+        lua_pop(L, 1);
     }
 }
 
@@ -1147,11 +1192,93 @@ client_get_nofocus_window(client_t *c)
                           -2, -2, 1, 1, 0, XCB_COPY_FROM_PARENT, globalconf.visual->visual_id,
                           0, NULL);
         xcb_map_window(globalconf.connection, c->nofocus_window);
-        xwindow_grabkeys(c->nofocus_window, &c->keys);
+        xwindow_grabkeys(c->nofocus_window, c->keys);
     }
     return c->nofocus_window;
 }
 
+static void
+client_set_responsive(client_t *c, bool responsive)
+{
+    if(c->responsive == responsive)
+        return;
+
+    lua_State *L = globalconf_get_lua_State();
+    c->responsive = responsive;
+    luaA_object_push(L, c);
+    luaA_object_emit_signal(L, -1, "property::responsive", 0);
+    lua_pop(L, 1);
+}
+
+static gboolean
+client_ping_timeout(gpointer data)
+{
+    client_t *c = data;
+
+    c->ping_source = 0;
+    if(c->kill_on_ping_timeout)
+    {
+        c->kill_on_ping_timeout = false;
+        xcb_kill_client(globalconf.connection, c->window);
+    }
+    client_set_responsive(c, false);
+
+    return G_SOURCE_REMOVE;
+}
+
+/** Send a _NET_WM_PING request to a client. It is marked as unresponsive if
+ * it does not answer in time. Nothing waits for the answer.
+ * \param c The client.
+ * \param timeout The time the client gets to answer, in milliseconds.
+ * \return False if the client does not support _NET_WM_PING.
+ */
+static bool
+client_ping(client_t *c, unsigned int timeout)
+{
+    xcb_client_message_event_t ev;
+
+    if(!client_hasproto(c, _NET_WM_PING))
+        return false;
+
+    p_clear(&ev, 1);
+    ev.response_type = XCB_CLIENT_MESSAGE;
+    ev.window = c->window;
+    ev.format = 32;
+    ev.type = WM_PROTOCOLS;
+    /* Replies are told apart by their timestamp, so never reuse one */
+    c->ping_timestamp = MAX(globalconf.timestamp, c->ping_timestamp + 1);
+
+    ev.data.data32[0] = _NET_WM_PING;
+    ev.data.data32[1] = c->ping_timestamp;
+    ev.data.data32[2] = c->window;
+
+    xcb_send_event(globalconf.connection, false, c->window,
+                   XCB_EVENT_MASK_NO_EVENT, (char *) &ev);
+
+    if(c->ping_source)
+        g_source_remove(c->ping_source);
+    c->ping_source = g_timeout_add(timeout, client_ping_timeout, c);
+    return true;
+}
+
+/** Handle the answer of a client to a _NET_WM_PING request. Answers to
+ * earlier requests than the last one are ignored.
+ * \param c The client.
+ * \param timestamp The timestamp of the request that is answered.
+ */
+void
+client_ping_reply(client_t *c, xcb_timestamp_t timestamp)
+{
+    if(timestamp != c->ping_timestamp)
+        return;
+    if(c->ping_source)
+        g_source_remove(c->ping_source);
+    c->ping_source = 0;
+    /* It is alive, so it is probably asking the user what to do */
+    c->kill_on_ping_timeout = false;
+    client_set_responsive(c, true);
+}
+
 void
 client_focus_refresh(void)
 {
@@ -1172,8 +1299,13 @@ client_focus_refresh(void)
         else
             win = client_get_nofocus_window(c);
 
-        if(client_hasproto(c, WM_TAKE_FOCUS))
+        /* A hung client would not act on WM_TAKE_FOCUS anyway */
+        if(client_hasproto(c, WM_TAKE_FOCUS) && c->responsive)
             xwindow_takefocus(c->window);
+
+        /* Check whether it is still alive, without waiting for it */
+        if(!c->ping_source)
+            client_ping(c, CLIENT_PING_TIMEOUT);
     }
 
     /* If nothing has the focus or the currently focused client does not want
@@ -1192,14 +1324,30 @@ client_border_refresh(void)
         window_border_refresh((window_t *) *c);
 }
 
+/** Mark the X11 geometry of a client as needing an update. This is done once
+ * per main loop iteration by client_geometry_refresh(), which only looks at
+ * the clients marked this way.
+ * \param c The client.
+ */
+void
+client_need_geometry_refresh(client_t *c)
+{
+    if(c->geometry_dirty)
+        return;
+    c->geometry_dirty = true;
+    client_array_append(&globalconf.geometry_dirty_clients, c);
+}
+
 static void
 client_geometry_refresh(void)
 {
     bool ignored_enterleave = false;
-    foreach(_c, globalconf.clients)
+    foreach(_c, globalconf.geometry_dirty_clients)
     {
         client_t *c = *_c;
 
+        c->geometry_dirty = false;
+
         /* Compute the client window's and frame window's geometry */
         area_t geometry = c->geometry;
         area_t real_geometry = c->geometry;
@@ -1269,6 +1417,8 @@ client_geometry_refresh(void)
     }
     if (ignored_enterleave)
         client_restore_enterleave_events();
+
+    globalconf.geometry_dirty_clients.len = 0;
 }
 
 void
@@ -1290,6 +1440,7 @@ client_destroy_later(void)
             ignored_enterleave = true;
         }
         xcb_destroy_window(globalconf.connection, *window);
+        xwindow_grabs_forget(*window);
     }
     if (ignored_enterleave)
         client_restore_enterleave_events();
@@ -1391,6 +1542,8 @@ client_manage(xcb_window_t w, xcb_get_geometry_reply_t *wgeom, xcb_get_window_at
 
     /* consider the window banned */
     c->isbanned = true;
+    /* until proven otherwise */
+    c->responsive = true;
     /* Store window and visual */
     c->window = w;
     c->visualtype = draw_find_visual(globalconf.screen, wattr->visual);
@@ -1461,6 +1614,7 @@ client_manage(xcb_window_t w, xcb_get_geometry_reply_t *wgeom, xcb_get_window_at
     c->geometry.y = wgeom->y;
     c->geometry.width = wgeom->width;
     c->geometry.height = wgeom->height;
+    client_need_geometry_refresh(c);
 
     luaA_object_emit_signal(L, -1, "property::x", 0);
     luaA_object_emit_signal(L, -1, "property::y", 0);
@@ -1660,18 +1814,15 @@ client_apply_size_hints(client_t *c, area_t geometry)
     return geometry;
 }
 
+/** Emit the signals for a change of a client's geometry.
+ * \param L The Lua VM state.
+ * \param c The client.
+ * \param old_geometry The geometry before the change.
+ */
 static void
-client_resize_do(client_t *c, area_t geometry)
+client_emit_geometry_signals(lua_State *L, client_t *c, area_t old_geometry)
 {
-    lua_State *L = globalconf_get_lua_State();
-
-    screen_t *new_screen = c->screen;
-    if(!screen_area_in_screen(new_screen, geometry))
-        new_screen = screen_getbycoord(geometry.x, geometry.y);
-
-    /* Also store geometry including border */
-    area_t old_geometry = c->geometry;
-    c->geometry = geometry;
+    area_t geometry = c->geometry;
 
     luaA_object_push(L, c);
     if (!AREA_EQUAL(old_geometry, geometry))
@@ -1693,6 +1844,76 @@ client_resize_do(client_t *c, area_t geometry)
             luaA_object_emit_signal(L, -1, "property::height", 0);
     }
     lua_pop(L, 1);
+}
+
+/** Start deferring the geometry signals of clients. Batches can be nested. */
+void
+client_batch_begin(void)
+{
+    globalconf.client_batch_depth++;
+}
+
+/** End a batch started with client_batch_begin(). When the outermost batch
+ * ends, every client whose geometry changed emits its signals once, comparing
+ * its geometry from before the batch with the current one.
+ * \param L The Lua VM state.
+ */
+void
+client_batch_commit(lua_State *L)
+{
+    if (globalconf.client_batch_depth <= 0 || --globalconf.client_batch_depth > 0)
+        return;
+
+    /* Signal handlers may resize clients again, which is no longer batched */
+    client_array_t clients = globalconf.batch_clients;
+    client_array_init(&globalconf.batch_clients);
+
+    foreach(_c, clients)
+    {
+        client_t *c = *_c;
+        /* Cleared if the client got unmanaged by an earlier signal handler */
+        if (c->batch_pending)
+        {
+            c->batch_pending = false;
+            if (!AREA_EQUAL(c->batch_geometry, c->geometry))
+                client_emit_geometry_signals(L, c, c->batch_geometry);
+        }
+        /* Drop the reference taken by client_resize_do() */
+        luaA_object_unref(L, c);
+    }
+
+    client_array_wipe(&clients);
+}
+
+static void
+client_resize_do(client_t *c, area_t geometry)
+{
+    lua_State *L = globalconf_get_lua_State();
+
+    screen_t *new_screen = c->screen;
+    if(!screen_area_in_screen(new_screen, geometry))
+        new_screen = screen_getbycoord(geometry.x, geometry.y);
+
+    /* Also store geometry including border */
+    area_t old_geometry = c->geometry;
+    c->geometry = geometry;
+    client_need_geometry_refresh(c);
+
+    if (globalconf.client_batch_depth > 0)
+    {
+        /* Signals are emitted once when the batch ends */
+        if (!c->batch_pending && !AREA_EQUAL(old_geometry, geometry))
+        {
+            c->batch_pending = true;
+            c->batch_geometry = old_geometry;
+            /* Keep the client alive until the batch ends */
+            luaA_object_push(L, c);
+            luaA_object_ref(L, -1);
+            client_array_append(&globalconf.batch_clients, c);
+        }
+    }
+    else
+        client_emit_geometry_signals(L, c, old_geometry);
 
     screen_client_moveto(c, new_screen, false);
 
@@ -2118,16 +2339,19 @@ client_unban(client_t *c)
     lua_State *L = globalconf_get_lua_State();
     if(c->isbanned)
     {
-        xcb_map_window(globalconf.connection, c->frame_window);
-
         c->isbanned = false;
 
         /* An unbanned client shouldn't be minimized or hidden */
         luaA_object_push(L, c);
         client_set_minimized(L, -1, false);
         client_set_hidden(L, -1, false);
+        /* Titlebars are repainted by this signal, so emit it before the frame
+         * gets mapped with their old content */
+        luaA_object_emit_signal(L, -1, "property::banned", 0);
         lua_pop(L, 1);
 
+        xcb_map_window(globalconf.connection, c->frame_window);
+
         if (globalconf.focus.client == c)
             globalconf.focus.need_update = true;
     }
@@ -2160,6 +2384,34 @@ client_unmanage(client_t *c, bool window_valid)
             client_array_remove(&globalconf.clients, elem);
             break;
         }
+    if(c->batch_pending)
+    {
+        c->batch_pending = false;
+        /* During client_batch_commit() the client is no longer in this
+         * array, and the commit drops the reference itself */
+        foreach(elem, globalconf.batch_clients)
+            if(*elem == c)
+            {
+                client_array_remove(&globalconf.batch_clients, elem);
+                luaA_object_unref(L, c);
+                break;
+            }
+    }
+    if(c->ping_source)
+    {
+        g_source_remove(c->ping_source);
+        c->ping_source = 0;
+    }
+    if(c->geometry_dirty)
+    {
+        c->geometry_dirty = false;
+        foreach(elem, globalconf.geometry_dirty_clients)
+            if(*elem == c)
+            {
+                client_array_remove(&globalconf.geometry_dirty_clients, elem);
+                break;
+            }
+    }
     stack_client_remove(c);
     for(int i = 0; i < globalconf.tags.len; i++)
         untag_client(c, globalconf.tags.tab[i]);
@@ -2170,8 +2422,8 @@ client_unmanage(client_t *c, bool window_valid)
 
     luaA_class_emit_signal(L, &client_class, "list", 0);
 
-    if(strut_has_value(&c->strut))
-        screen_update_workarea(c->screen);
+    screen_strut_client_remove(c);
+    key_set_unref(L, &c->keys);
 
     /* Get rid of all titlebars */
     for (client_titlebar_t bar = CLIENT_TITLEBAR_TOP; bar < CLIENT_TITLEBAR_COUNT; bar++) {
@@ -2228,6 +2480,9 @@ client_unmanage(client_t *c, bool window_valid)
         xwindow_set_state(c->window, XCB_ICCCM_WM_STATE_WITHDRAWN);
     }
 
+    /* The window may come back with a new set of grabs */
+    xwindow_grabs_forget(c->window);
+
     /* set client as invalid */
     c->window = XCB_NONE;
 
@@ -2237,9 +2492,12 @@ client_unmanage(client_t *c, bool window_valid)
 /** Kill a client via a WM_DELETE_WINDOW request or KillClient if not
  * supported.
  * \param c The client to kill.
+ * \param timeout If non-zero, the time in milliseconds the client gets to
+ * answer a _NET_WM_PING request sent along WM_DELETE_WINDOW. It is killed with
+ * KillClient if it doesn't.
  */
 void
-client_kill(client_t *c)
+client_kill(client_t *c, unsigned int timeout)
 {
     if(client_hasproto(c, WM_DELETE_WINDOW))
     {
@@ -2257,11 +2515,51 @@ client_kill(client_t *c)
 
         xcb_send_event(globalconf.connection, false, c->window,
                        XCB_EVENT_MASK_NO_EVENT, (char *) &ev);
+
+        if(timeout > 0 && client_ping(c, timeout))
+            c->kill_on_ping_timeout = true;
     }
     else
         xcb_kill_client(globalconf.connection, c->window);
 }
 
+/** Change clients without emitting their geometry signals right away.
+ *
+ * While the function runs, the `property::geometry`, `property::position`,
+ * `property::size`, `property::x`, `property::y`, `property::width` and
+ * `property::height` signals of clients are held back. When it returns, each
+ * client that was moved or resized emits them at most once, for its overall
+ * change. Calls can be nested, the signals are emitted when the outermost
+ * one returns. Errors are propagated after the signals were emitted.
+ *
+ * @usage client.batch(function()
+ *     for _, c in ipairs(client.get()) do
+ *         c:geometry({ width = 200 })
+ *     end
+ * end)
+ *
+ * @tparam function func The function to call.
+ * @function batch
+ */
+static int
+luaA_client_batch(lua_State *L)
+{
+    luaL_checktype(L, 1, LUA_TFUNCTION);
+    lua_settop(L, 1);
+
+    /* Keep the traceback of errors, like luaA_dofunction() */
+    lua_pushcfunction(L, luaA_dofunction_error);
+    lua_insert(L, 1);
+
+    client_batch_begin();
+    int status = lua_pcall(L, 0, 0, 1);
+    client_batch_commit(L);
+
+    if (status != 0)
+        return lua_error(L);
+    return 0;
+}
+
 /** Get all clients into a table.
  *
  * @tparam[opt] integer screen A screen number to filter clients on.
@@ -2407,13 +2705,27 @@ out:
 
 /** Kill a client.
  *
+ * The client is asked to close itself. If it does not support that, it is
+ * killed right away.
+ *
+ * When a timeout is given and the client supports `_NET_WM_PING`, the client
+ * is also pinged. If it does not answer within the timeout, it is considered
+ * hung and killed. A client that answers but stays open, for example to ask
+ * about unsaved changes, is left alone.
+ *
+ * @tparam[opt] number timeout The time in seconds before a hung client is
+ *   killed.
  * @function kill
  */
 static int
 luaA_client_kill(lua_State *L)
 {
     client_t *c = luaA_checkudata(L, 1, &client_class);
-    client_kill(c);
+    unsigned int timeout = 0;
+
+    if(!lua_isnoneornil(L, 2))
+        timeout = MAX(1, luaA_checknumber_range(L, 2, 0, 3600) * 1000);
+    client_kill(c, timeout);
     return 0;
 }
 
@@ -2852,6 +3164,24 @@ luaA_client_geometry(lua_State *L)
     return luaA_pusharea(L, c->geometry);
 }
 
+/** Return the client geometry without creating a table.
+ *
+ * This is cheaper than `geometry` when only reading the geometry, for example
+ * in code called for each client on every relayout.
+ *
+ * @treturn integer The x coordinate.
+ * @treturn integer The y coordinate.
+ * @treturn integer The width.
+ * @treturn integer The height.
+ * @function unpacked_geometry
+ */
+static int
+luaA_client_unpacked_geometry(lua_State *L)
+{
+    client_t *c = luaA_checkudata(L, 1, &client_class);
+    return luaA_pusharea_unpacked(L, c->geometry);
+}
+
 /** Apply size hints to a size.
  *
  * @param width Desired width of client
@@ -3048,6 +3378,8 @@ LUA_OBJECT_EXPORT_PROPERTY(client, client_t, fullscreen, lua_pushboolean)
 LUA_OBJECT_EXPORT_PROPERTY(client, client_t, modal, lua_pushboolean)
 LUA_OBJECT_EXPORT_PROPERTY(client, client_t, ontop, lua_pushboolean)
 LUA_OBJECT_EXPORT_PROPERTY(client, client_t, urgent, lua_pushboolean)
+LUA_OBJECT_EXPORT_PROPERTY(client, client_t, responsive, lua_pushboolean)
+LUA_OBJECT_EXPORT_PROPERTY(client, client_t, isbanned, lua_pushboolean)
 LUA_OBJECT_EXPORT_PROPERTY(client, client_t, above, lua_pushboolean)
 LUA_OBJECT_EXPORT_PROPERTY(client, client_t, below, lua_pushboolean)
 LUA_OBJECT_EXPORT_PROPERTY(client, client_t, sticky, lua_pushboolean)
@@ -3268,13 +3600,10 @@ luaA_client_get_shape_bounding(lua_State *L, client_t *c)
 static int
 luaA_client_set_shape_bounding(lua_State *L, client_t *c)
 {
-    cairo_surface_t *surf = NULL;
-    if(!lua_isnil(L, -1))
-        surf = (cairo_surface_t *)lua_touserdata(L, -1);
-    xwindow_set_shape(c->frame_window,
+    luaA_xwindow_set_shape(L, -1, c->frame_window,
             c->geometry.width + (c->border_width * 2),
             c->geometry.height + (c->border_width * 2),
-            XCB_SHAPE_SK_BOUNDING, surf, -c->border_width);
+            XCB_SHAPE_SK_BOUNDING, -c->border_width);
     luaA_object_emit_signal(L, -3, "property::shape_bounding", 0);
     return 0;
 }
@@ -3319,11 +3648,8 @@ luaA_client_get_shape_clip(lua_State *L, client_t *c)
 static int
 luaA_client_set_shape_clip(lua_State *L, client_t *c)
 {
-    cairo_surface_t *surf = NULL;
-    if(!lua_isnil(L, -1))
-        surf = (cairo_surface_t *)lua_touserdata(L, -1);
-    xwindow_set_shape(c->frame_window, c->geometry.width, c->geometry.height,
-            XCB_SHAPE_SK_CLIP, surf, 0);
+    luaA_xwindow_set_shape(L, -1, c->frame_window, c->geometry.width, c->geometry.height,
+            XCB_SHAPE_SK_CLIP, 0);
     luaA_object_emit_signal(L, -3, "property::shape_clip", 0);
     return 0;
 }
@@ -3352,13 +3678,10 @@ luaA_client_get_shape_input(lua_State *L, client_t *c)
 static int
 luaA_client_set_shape_input(lua_State *L, client_t *c)
 {
-    cairo_surface_t *surf = NULL;
-    if(!lua_isnil(L, -1))
-        surf = (cairo_surface_t *)lua_touserdata(L, -1);
-    xwindow_set_shape(c->frame_window,
+    luaA_xwindow_set_shape(L, -1, c->frame_window,
             c->geometry.width + (c->border_width * 2),
             c->geometry.height + (c->border_width * 2),
-            XCB_SHAPE_SK_INPUT, surf, -c->border_width);
+            XCB_SHAPE_SK_INPUT, -c->border_width);
     luaA_object_emit_signal(L, -3, "property::shape_input", 0);
     return 0;
 }
@@ -3373,18 +3696,22 @@ static int
 luaA_client_keys(lua_State *L)
 {
     client_t *c = luaA_checkudata(L, 1, &client_class);
-    key_array_t *keys = &c->keys;
 
     if(lua_gettop(L) == 2)
     {
-        luaA_key_array_set(L, 1, 2, keys);
-        luaA_object_emit_signal(L, 1, "property::keys", 0);
-        xwindow_grabkeys(c->window, keys);
+        key_set_t *old_keys = c->keys;
+        c->keys = luaA_key_set_new(L, 2);
+        key_set_unref(L, &old_keys);
+
+        /* Keys may have been changed in place, so always regrab. Only the
+         * grabs that differ are sent to the server. */
+        xwindow_grabkeys(c->window, c->keys);
         if (c->nofocus_window)
-            xwindow_grabkeys(c->nofocus_window, &c->keys);
+            xwindow_grabkeys(c->nofocus_window, c->keys);
+        luaA_object_emit_signal(L, 1, "property::keys", 0);
     }
 
-    return luaA_key_array_get(L, 1, keys);
+    return luaA_key_set_push(L, c->keys);
 }
 
 static int
@@ -3449,6 +3776,7 @@ client_class_setup(lua_State *L)
     {
         LUA_CLASS_METHODS(client)
         { "get", luaA_client_get },
+        { "batch", luaA_client_batch },
         { "__index", luaA_client_module_index },
         { "__newindex", luaA_client_module_newindex },
         { NULL, NULL }
@@ -3461,6 +3789,7 @@ client_class_setup(lua_State *L)
         { "keys", luaA_client_keys },
         { "isvisible", luaA_client_isvisible },
         { "geometry", luaA_client_geometry },
+        { "unpacked_geometry", luaA_client_unpacked_geometry },
         { "apply_size_hints", luaA_client_apply_size_hints },
         { "tags", luaA_client_tags },
         { "kill", luaA_client_kill },
@@ -3518,6 +3847,14 @@ client_class_setup(lua_State *L)
                             NULL,
                             (lua_class_propfunc_t) luaA_client_get_pid,
                             NULL);
+    luaA_class_add_property(&client_class, "responsive",
+                            NULL,
+                            (lua_class_propfunc_t) luaA_client_get_responsive,
+                            NULL);
+    luaA_class_add_property(&client_class, "banned",
+                            NULL,
+                            (lua_class_propfunc_t) luaA_client_get_isbanned,
+                            NULL);
     luaA_class_add_property(&client_class, "leader_window",
                             NULL,
                             (lua_class_propfunc_t) luaA_client_get_leader_window,
@@ -61,11 +61,25 @@ struct client_t
     char *class, *instance;
     /** Window geometry */
     area_t geometry;
+    /** Geometry before the current client.batch(), if it changed since */
+    area_t batch_geometry;
+    /** Is this client in globalconf.batch_clients? */
+    bool batch_pending;
+    /** Did the client answer the last _NET_WM_PING in time? */
+    bool responsive;
+    /** Timeout of the unanswered _NET_WM_PING, or 0 */
+    guint ping_source;
+    /** Timestamp of the last _NET_WM_PING request */
+    xcb_timestamp_t ping_timestamp;
+    /** Should the client be killed if the ping times out? */
+    bool kill_on_ping_timeout;
     /** Old window geometry currently configured in X11 */
     area_t x11_client_geometry;
     area_t x11_frame_geometry;
     /** Got a configure request and have to call client_send_configure() if its ignored? */
     bool got_configure_request;
+    /** Is this client in globalconf.geometry_dirty_clients? */
+    bool geometry_dirty;
     /** Startup ID */
     char *startup_id;
     /** True if the client is sticky */
@@ -114,8 +128,8 @@ struct client_t
     xcb_window_t leader_window;
     /** Client's WM_PROTOCOLS property */
     xcb_icccm_get_wm_protocols_reply_t protocols;
-    /** Key bindings */
-    key_array_t keys;
+    /** Key bindings, shared with the clients having the same ones */
+    key_set_t *keys;
     /** Icon */
     cairo_surface_t *icon;
     /** True if we ever got an icon from _NET_WM_ICON */
@@ -162,8 +176,12 @@ void client_ban_unfocus(client_t *);
 void client_unban(client_t *);
 void client_manage(xcb_window_t, xcb_get_geometry_reply_t *, xcb_get_window_attributes_reply_t *);
 bool client_resize(client_t *, area_t, bool);
+void client_need_geometry_refresh(client_t *);
+void client_batch_begin(void);
+void client_batch_commit(lua_State *);
 void client_unmanage(client_t *, bool);
-void client_kill(client_t *);
+void client_kill(client_t *, unsigned int);
+void client_ping_reply(client_t *, xcb_timestamp_t);
 void client_set_sticky(lua_State *, int, bool);
 void client_set_above(lua_State *, int, bool);
 void client_set_below(lua_State *, int, bool);
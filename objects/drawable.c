@@ -212,6 +212,21 @@ luaA_drawable_geometry(lua_State *L)
     return luaA_pusharea(L, d->geometry);
 }
 
+/** Get drawable geometry without creating a table.
+ *
+ * @treturn integer The x coordinate.
+ * @treturn integer The y coordinate.
+ * @treturn integer The width.
+ * @treturn integer The height.
+ * @function unpacked_geometry
+ */
+static int
+luaA_drawable_unpacked_geometry(lua_State *L)
+{
+    drawable_t *d = luaA_checkudata(L, 1, &drawable_class);
+    return luaA_pusharea_unpacked(L, d->geometry);
+}
+
 void
 drawable_class_setup(lua_State *L)
 {
@@ -227,6 +242,7 @@ drawable_class_setup(lua_State *L)
         LUA_CLASS_META
         { "refresh", luaA_drawable_refresh },
         { "geometry", luaA_drawable_geometry },
+        { "unpacked_geometry", luaA_drawable_unpacked_geometry },
         { NULL, NULL },
     };
 
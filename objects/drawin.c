@@ -64,6 +64,8 @@
  * @field shape_bounding The drawin's bounding shape as a (native) cairo surface.
  * @field shape_clip The drawin's clip shape as a (native) cairo surface.
  * @field shape_input The drawin's input shape as a (native) cairo surface.
+ * The shapes can also be set from a table describing a simple shape, see
+ * `gears.shape.native_description`.
  * @table drawin
  */
 
@@ -172,11 +174,13 @@ drawin_wipe(drawin_t *w)
     /* The drawin must already be unmapped, else it
      * couldn't be garbage collected -> no unmap needed */
     p_delete(&w->cursor);
+    screen_strut_drawin_remove(w);
     if(w->window)
     {
         /* Make sure we don't accidentally kill the systray window */
         drawin_systray_kickout(w);
         xcb_destroy_window(globalconf.connection, w->window);
+        xwindow_grabs_forget(w->window);
         w->window = XCB_NONE;
     }
     /* No unref needed because we are being garbage collected */
@@ -263,12 +267,11 @@ drawin_moveresize(lua_State *L, int udx, area_t geometry)
     if (old_geometry.height != w->geometry.height)
         luaA_object_emit_signal(L, udx, "property::height", 0);
 
-    screen_t *old_screen = screen_getbycoord(old_geometry.x, old_geometry.y);
-    screen_t *new_screen = screen_getbycoord(w->geometry.x, w->geometry.y);
-    if (old_screen != new_screen && strut_has_value(&w->strut))
+    if (!AREA_EQUAL(old_geometry, w->geometry) && strut_has_value(&w->strut))
     {
-        screen_update_workarea(old_screen);
-        screen_update_workarea(new_screen);
+        /* Partial struts depend on the geometry, not only on the screen */
+        screen_update_workarea(screen_getbycoord(old_geometry.x, old_geometry.y));
+        screen_update_workarea(screen_getbycoord(w->geometry.x, w->geometry.y));
     }
 }
 
@@ -476,6 +479,21 @@ luaA_drawin_geometry(lua_State *L)
     return luaA_pusharea(L, drawin->geometry);
 }
 
+/** Get the drawin geometry without creating a table.
+ *
+ * @treturn integer The x coordinate.
+ * @treturn integer The y coordinate.
+ * @treturn integer The width.
+ * @treturn integer The height.
+ * @function unpacked_geometry
+ */
+static int
+luaA_drawin_unpacked_geometry(lua_State *L)
+{
+    drawin_t *drawin = luaA_checkudata(L, 1, &drawin_class);
+    return luaA_pusharea_unpacked(L, drawin->geometry);
+}
+
 
 LUA_OBJECT_EXPORT_PROPERTY(drawin, drawin_t, ontop, lua_pushboolean)
 LUA_OBJECT_EXPORT_PROPERTY(drawin, drawin_t, cursor, lua_pushstring)
@@ -643,17 +661,13 @@ luaA_drawin_get_shape_bounding(lua_State *L, drawin_t *drawin)
 static int
 luaA_drawin_set_shape_bounding(lua_State *L, drawin_t *drawin)
 {
-    cairo_surface_t *surf = NULL;
-    if(!lua_isnil(L, -1))
-        surf = (cairo_surface_t *)lua_touserdata(L, -1);
-
     /* The drawin might have been resized to a larger size. Apply that. */
     drawin_apply_moveresize(drawin);
 
-    xwindow_set_shape(drawin->window,
+    luaA_xwindow_set_shape(L, -1, drawin->window,
             drawin->geometry.width + 2*drawin->border_width,
             drawin->geometry.height + 2*drawin->border_width,
-            XCB_SHAPE_SK_BOUNDING, surf, -drawin->border_width);
+            XCB_SHAPE_SK_BOUNDING, -drawin->border_width);
     luaA_object_emit_signal(L, -3, "property::shape_bounding", 0);
     return 0;
 }
@@ -682,15 +696,11 @@ luaA_drawin_get_shape_clip(lua_State *L, drawin_t *drawin)
 static int
 luaA_drawin_set_shape_clip(lua_State *L, drawin_t *drawin)
 {
-    cairo_surface_t *surf = NULL;
-    if(!lua_isnil(L, -1))
-        surf = (cairo_surface_t *)lua_touserdata(L, -1);
-
     /* The drawin might have been resized to a larger size. Apply that. */
     drawin_apply_moveresize(drawin);
 
-    xwindow_set_shape(drawin->window, drawin->geometry.width, drawin->geometry.height,
-            XCB_SHAPE_SK_CLIP, surf, 0);
+    luaA_xwindow_set_shape(L, -1, drawin->window, drawin->geometry.width, drawin->geometry.height,
+            XCB_SHAPE_SK_CLIP, 0);
     luaA_object_emit_signal(L, -3, "property::shape_clip", 0);
     return 0;
 }
@@ -719,17 +729,13 @@ luaA_drawin_get_shape_input(lua_State *L, drawin_t *drawin)
 static int
 luaA_drawin_set_shape_input(lua_State *L, drawin_t *drawin)
 {
-    cairo_surface_t *surf = NULL;
-    if(!lua_isnil(L, -1))
-        surf = (cairo_surface_t *)lua_touserdata(L, -1);
-
     /* The drawin might have been resized to a larger size. Apply that. */
     drawin_apply_moveresize(drawin);
 
-    xwindow_set_shape(drawin->window,
+    luaA_xwindow_set_shape(L, -1, drawin->window,
             drawin->geometry.width + 2*drawin->border_width,
             drawin->geometry.height + 2*drawin->border_width,
-            XCB_SHAPE_SK_INPUT, surf, -drawin->border_width);
+            XCB_SHAPE_SK_INPUT, -drawin->border_width);
     luaA_object_emit_signal(L, -3, "property::shape_input", 0);
     return 0;
 }
@@ -749,6 +755,7 @@ drawin_class_setup(lua_State *L)
         LUA_OBJECT_META(drawin)
         LUA_CLASS_META
         { "geometry", luaA_drawin_geometry },
+        { "unpacked_geometry", luaA_drawin_unpacked_geometry },
         { NULL, NULL },
     };
 
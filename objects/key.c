@@ -35,6 +35,7 @@
  */
 
 #include "objects/key.h"
+#include "globalconf.h"
 #include "common/xutil.h"
 #include "xkb.h"
 
@@ -87,6 +88,246 @@
  * @function set_newindex_miss_handler
  */
 
+DO_ARRAY(key_set_t *, key_set, DO_NOTHING)
+
+/** All live key sets, so that identical sets are only created once */
+static key_set_array_t key_sets;
+/** Bumped every time a key object or the keymap changes, invalidating the
+ * index and the grabs of all key sets */
+static unsigned int key_generation = 1;
+
+static inline uint64_t
+key_index_id(bool is_keycode, uint32_t code, uint16_t modifiers)
+{
+    return ((uint64_t) is_keycode << 48) | ((uint64_t) code << 16) | modifiers;
+}
+
+static void
+key_index_insert(key_bucket_array_t *index, uint64_t id, int position)
+{
+    key_bucket_t bucket = { .id = id };
+    key_bucket_t *found = key_bucket_array_lookup(index, &bucket);
+
+    if(!found)
+    {
+        key_bucket_array_insert(index, bucket);
+        found = key_bucket_array_lookup(index, &bucket);
+    }
+    key_position_array_append(&found->positions, position);
+}
+
+/** Rebuild the lookup index and the passive grabs of a key set if a key or
+ * the keymap changed since they were computed.
+ * \param set The key set.
+ */
+static void
+key_set_update(key_set_t *set)
+{
+    if(set->generation == key_generation)
+        return;
+
+    set->generation = key_generation;
+    key_bucket_array_wipe(&set->index);
+    key_bucket_array_init(&set->index);
+    key_grab_array_wipe(&set->grabs);
+    key_grab_array_init(&set->grabs);
+
+    for(int i = 0; i < set->keys.len; i++)
+    {
+        keyb_t *k = set->keys.tab[i];
+        if(k->keycode)
+        {
+            key_index_insert(&set->index, key_index_id(true, k->keycode, k->modifiers), i);
+            key_grab_array_append(&set->grabs,
+                                  (key_grab_t) { .modifiers = k->modifiers, .keycode = k->keycode });
+        }
+        else if(k->keysym)
+        {
+            key_index_insert(&set->index, key_index_id(false, k->keysym, k->modifiers), i);
+
+            xcb_keycode_t *keycodes = xcb_key_symbols_get_keycode(globalconf.keysyms, k->keysym);
+            if(keycodes)
+            {
+                for(xcb_keycode_t *kc = keycodes; *kc; kc++)
+                    key_grab_array_append(&set->grabs,
+                                          (key_grab_t) { .modifiers = k->modifiers, .keycode = *kc });
+                p_delete(&keycodes);
+            }
+        }
+    }
+}
+
+/** Get a key set from a Lua table of keys. Sets are immutable and shared:
+ * if a set with the same keys in the same order already exists, it is
+ * returned instead of creating a new one.
+ * \param L The Lua VM state.
+ * \param idx The index of the Lua table.
+ * \return A new reference to the key set.
+ */
+key_set_t *
+luaA_key_set_new(lua_State *L, int idx)
+{
+    key_array_t keys;
+
+    idx = luaA_absindex(L, idx);
+    luaA_checktable(L, idx);
+
+    key_array_init(&keys);
+    lua_pushnil(L);
+    while(lua_next(L, idx))
+    {
+        keyb_t *k = luaA_toudata(L, -1, &key_class);
+        if(k)
+            key_array_append(&keys, k);
+        lua_pop(L, 1);
+    }
+
+    foreach(set, key_sets)
+        if((*set)->keys.len == keys.len
+           && !memcmp((*set)->keys.tab, keys.tab, sizeof(*keys.tab) * keys.len))
+        {
+            key_array_wipe(&keys);
+            (*set)->refcount++;
+            return *set;
+        }
+
+    key_set_t *set = p_new(key_set_t, 1);
+    set->refcount = 1;
+    set->keys = keys;
+
+    /* The set holds a single reference to each of its keys */
+    lua_pushnil(L);
+    while(lua_next(L, idx))
+        if(luaA_toudata(L, -1, &key_class))
+            luaA_object_ref(L, -1);
+        else
+            lua_pop(L, 1);
+
+    key_set_array_append(&key_sets, set);
+    return set;
+}
+
+/** Release a reference to a key set.
+ * \param L The Lua VM state.
+ * \param set A pointer to the key set, set to NULL.
+ */
+void
+key_set_unref(lua_State *L, key_set_t **set)
+{
+    if(!*set)
+        return;
+
+    if(--(*set)->refcount == 0)
+    {
+        foreach(elem, key_sets)
+            if(*elem == *set)
+            {
+                key_set_array_remove(&key_sets, elem);
+                break;
+            }
+        foreach(k, (*set)->keys)
+            luaA_object_unref(L, *k);
+        key_array_wipe(&(*set)->keys);
+        key_bucket_array_wipe(&(*set)->index);
+        key_grab_array_wipe(&(*set)->grabs);
+        p_delete(set);
+    }
+    *set = NULL;
+}
+
+/** Push the keys of a key set as a Lua table.
+ * \param L The Lua VM state.
+ * \param set The key set, may be NULL.
+ * \return The number of elements pushed on stack.
+ */
+int
+luaA_key_set_push(lua_State *L, key_set_t *set)
+{
+    int len = set ? set->keys.len : 0;
+
+    lua_createtable(L, len, 0);
+    for(int i = 0; i < len; i++)
+    {
+        luaA_object_push(L, set->keys.tab[i]);
+        lua_rawseti(L, -2, i + 1);
+    }
+    return 1;
+}
+
+/** Get the passive grabs needed by a key set with the current keymap.
+ * \param set The key set, may be NULL.
+ * \return The grabs, or NULL if there are none.
+ */
+key_grab_array_t *
+key_set_get_grabs(key_set_t *set)
+{
+    if(!set)
+        return NULL;
+    key_set_update(set);
+    return &set->grabs;
+}
+
+/** Invalidate the passive grabs of all key sets after a keymap change. */
+void
+key_set_keymap_changed(void)
+{
+    key_generation++;
+}
+
+static void
+key_set_lookup_bucket(key_set_t *set, uint64_t id, key_position_array_t *positions)
+{
+    key_bucket_t bucket = { .id = id };
+    key_bucket_t *found = key_bucket_array_lookup(&set->index, &bucket);
+
+    if(found)
+        key_position_array_splice(positions, positions->len, 0,
+                                  found->positions.tab, found->positions.len);
+}
+
+static int
+key_position_cmp(const void *a, const void *b)
+{
+    return *(const int *) a - *(const int *) b;
+}
+
+/** Find the bindings of a key set matching a key event.
+ * \param set The key set, may be NULL.
+ * \param keycode The keycode of the event.
+ * \param keysym The keysym of the event, ignoring modifiers.
+ * \param state The modifiers state of the event.
+ * \param result The array to which the matching keys are appended, in the
+ * order of the key set.
+ */
+void
+key_set_lookup(key_set_t *set, xcb_keycode_t keycode, xcb_keysym_t keysym,
+               uint16_t state, key_array_t *result)
+{
+    key_position_array_t positions;
+
+    if(!set)
+        return;
+
+    key_set_update(set);
+
+    key_position_array_init(&positions);
+    key_set_lookup_bucket(set, key_index_id(true, keycode, state), &positions);
+    key_set_lookup_bucket(set, key_index_id(true, keycode, XCB_BUTTON_MASK_ANY), &positions);
+    if(keysym)
+    {
+        key_set_lookup_bucket(set, key_index_id(false, keysym, state), &positions);
+        key_set_lookup_bucket(set, key_index_id(false, keysym, XCB_BUTTON_MASK_ANY), &positions);
+    }
+
+    /* Every key lives in exactly one bucket, so there are no duplicates */
+    if(positions.len > 1)
+        qsort(positions.tab, positions.len, sizeof(*positions.tab), key_position_cmp);
+    foreach(position, positions)
+        key_array_append(result, set->keys.tab[*position]);
+
+    key_position_array_wipe(&positions);
+}
+
 static void
 luaA_keystore(lua_State *L, int ud, const char *str, ssize_t len)
 {
@@ -176,49 +417,6 @@ luaA_key_new(lua_State *L)
     return luaA_class_new(L, &key_class);
 }
 
-/** Set a key array with a Lua table.
- * \param L The Lua VM state.
- * \param oidx The index of the object to store items into.
- * \param idx The index of the Lua table.
- * \param keys The array key to fill.
- */
-void
-luaA_key_array_set(lua_State *L, int oidx, int idx, key_array_t *keys)
-{
-    luaA_checktable(L, idx);
-
-    foreach(key, *keys)
-        luaA_object_unref_item(L, oidx, *key);
-
-    key_array_wipe(keys);
-    key_array_init(keys);
-
-    lua_pushnil(L);
-    while(lua_next(L, idx))
-        if(luaA_toudata(L, -1, &key_class))
-            key_array_append(keys, luaA_object_ref_item(L, oidx, -1));
-        else
-            lua_pop(L, 1);
-}
-
-/** Push an array of key as an Lua table onto the stack.
- * \param L The Lua VM state.
- * \param oidx The index of the object to get items from.
- * \param keys The key array to push.
- * \return The number of elements pushed on stack.
- */
-int
-luaA_key_array_get(lua_State *L, int oidx, key_array_t *keys)
-{
-    lua_createtable(L, keys->len, 0);
-    for(int i = 0; i < keys->len; i++)
-    {
-        luaA_object_push_item(L, oidx, keys->tab[i]);
-        lua_rawseti(L, -2, i + 1);
-    }
-    return 1;
-}
-
 /** Push a modifier set to a Lua table.
  * \param L The Lua VM state.
  * \param modifiers The modifier.
@@ -268,6 +466,7 @@ static int
 luaA_key_set_modifiers(lua_State *L, keyb_t *k)
 {
     k->modifiers = luaA_tomodifiers(L, -1);
+    key_generation++;
     luaA_object_emit_signal(L, -3, "property::modifiers", 0);
     return 0;
 }
@@ -335,6 +534,7 @@ luaA_key_set_key(lua_State *L, keyb_t *k)
 {
     size_t klen;
     const char *key = luaL_checklstring(L, -1, &klen);
+    key_generation++;
     luaA_keystore(L, -3, key, klen);
     return 0;
 }
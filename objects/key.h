@@ -39,10 +39,63 @@ lua_class_t key_class;
 LUA_OBJECT_FUNCS(key_class, keyb_t, key)
 DO_ARRAY(keyb_t *, key, DO_NOTHING)
 
+/** A passive grab needed for a key binding */
+typedef struct
+{
+    uint16_t modifiers;
+    xcb_keycode_t keycode;
+} key_grab_t;
+DO_ARRAY(key_grab_t, key_grab, DO_NOTHING)
+
+DO_ARRAY(int, key_position, DO_NOTHING)
+
+/** All the bindings of a key set sharing a key and a modifier mask */
+typedef struct
+{
+    /** The packed keysym or keycode and modifiers */
+    uint64_t id;
+    /** Positions of the bindings in the key set, in ascending order */
+    key_position_array_t positions;
+} key_bucket_t;
+
+static inline int
+key_bucket_cmp(const void *a, const void *b)
+{
+    const key_bucket_t *x = a, *y = b;
+    return x->id > y->id ? 1 : (x->id < y->id ? -1 : 0);
+}
+
+static inline void
+key_bucket_wipe(key_bucket_t *bucket)
+{
+    key_position_array_wipe(&bucket->positions);
+}
+
+DO_BARRAY(key_bucket_t, key_bucket, key_bucket_wipe, key_bucket_cmp)
+
+/** An immutable set of key bindings, shared by all holders of the same keys */
+typedef struct
+{
+    /** Number of holders of this set */
+    int refcount;
+    /** The keys, each referenced once by the set */
+    key_array_t keys;
+    /** Generation of the keys and keymap the fields below were built for */
+    unsigned int generation;
+    /** Lookup table from keysyms and keycodes to positions in keys */
+    key_bucket_array_t index;
+    /** The passive grabs needed for the keys */
+    key_grab_array_t grabs;
+} key_set_t;
+
 void key_class_setup(lua_State *);
 
-void luaA_key_array_set(lua_State *, int, int, key_array_t *);
-int luaA_key_array_get(lua_State *, int, key_array_t *);
+key_set_t *luaA_key_set_new(lua_State *, int);
+void key_set_unref(lua_State *, key_set_t **);
+int luaA_key_set_push(lua_State *, key_set_t *);
+key_grab_array_t *key_set_get_grabs(key_set_t *);
+void key_set_keymap_changed(void);
+void key_set_lookup(key_set_t *, xcb_keycode_t, xcb_keysym_t, uint16_t, key_array_t *);
 
 int luaA_pushmodifiers(lua_State *, uint16_t);
 uint16_t luaA_tomodifiers(lua_State *L, int ud);
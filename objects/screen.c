@@ -57,6 +57,9 @@
 #include <xcb/xinerama.h>
 #include <xcb/randr.h>
 
+/** How many times the workareas may change in one main loop iteration */
+#define WORKAREA_REFRESH_MAX_PASSES 10
+
 /** Screen is a table where indexes are screen numbers. You can use `screen[1]`
  * to get access to the first screen, etc. Alternatively, if RANDR information
  * is available, you can use output names for finding screen objects.
@@ -273,31 +276,135 @@ screen_add(lua_State *L, screen_array_t *screens)
     return new_screen;
 }
 
+/** Compute the refresh rate of a RandR mode.
+ * \param modes The modes listed in the screen resources.
+ * \param num_modes The number of modes.
+ * \param mode The mode.
+ * \return The refresh rate in Hz, or 0 if unknown.
+ */
+static double
+screen_mode_refresh_rate(xcb_randr_mode_info_t *modes, int num_modes, xcb_randr_mode_t mode)
+{
+    for(int i = 0; i < num_modes; i++)
+    {
+        double vtotal = modes[i].vtotal;
+
+        if(modes[i].id != mode)
+            continue;
+        if(modes[i].mode_flags & XCB_RANDR_MODE_FLAG_DOUBLE_SCAN)
+            vtotal *= 2;
+        if(modes[i].mode_flags & XCB_RANDR_MODE_FLAG_INTERLACE)
+            vtotal /= 2;
+        if(modes[i].htotal == 0 || vtotal == 0)
+            return 0;
+        return modes[i].dot_clock / (modes[i].htotal * vtotal);
+    }
+    return 0;
+}
+
 /* Monitors were introduced in RandR 1.5 */
 #ifdef XCB_RANDR_GET_MONITORS
+/** Compute the refresh rate of the fastest CRTC that drives a monitor.
+ * This uses the current screen resources, so that the server does not probe
+ * the outputs again, and sends all GetCrtcInfo requests before waiting for
+ * the first reply.
+ * \param screen_res_c The cookie of the GetScreenResourcesCurrent request.
+ * \param monitors_r The monitors.
+ * \return The refresh rate in Hz, or 0 if unknown.
+ */
+static double
+screen_monitors_refresh_rate(xcb_randr_get_screen_resources_current_cookie_t screen_res_c,
+                             xcb_randr_get_monitors_reply_t *monitors_r)
+{
+    xcb_randr_get_screen_resources_current_reply_t *screen_res_r =
+        xcb_randr_get_screen_resources_current_reply(globalconf.connection, screen_res_c, NULL);
+    double refresh_rate = 0;
+
+    if (screen_res_r == NULL) {
+        warn("RANDR GetScreenResourcesCurrent failed; this should not be possible");
+        return 0;
+    }
+
+    xcb_randr_mode_info_t *modes = xcb_randr_get_screen_resources_current_modes(screen_res_r);
+    int num_modes = xcb_randr_get_screen_resources_current_modes_length(screen_res_r);
+    int num_crtcs = screen_res_r->num_crtcs;
+    xcb_randr_crtc_t *randr_crtcs = xcb_randr_get_screen_resources_current_crtcs(screen_res_r);
+    xcb_randr_get_crtc_info_cookie_t *crtc_info_c = p_new(xcb_randr_get_crtc_info_cookie_t, num_crtcs);
+
+    for(int i = 0; i < num_crtcs; i++)
+        crtc_info_c[i] = xcb_randr_get_crtc_info(globalconf.connection, randr_crtcs[i], screen_res_r->config_timestamp);
+
+    for(int i = 0; i < num_crtcs; i++)
+    {
+        xcb_randr_get_crtc_info_reply_t *crtc = xcb_randr_get_crtc_info_reply(globalconf.connection, crtc_info_c[i], NULL);
+        bool used = false;
+
+        if(!crtc)
+            continue;
+
+        /* Does one of the CRTC's outputs belong to a monitor? */
+        xcb_randr_output_t *crtc_outputs = xcb_randr_get_crtc_info_outputs(crtc);
+        for(int j = 0; !used && j < xcb_randr_get_crtc_info_outputs_length(crtc); j++)
+            for(xcb_randr_monitor_info_iterator_t monitor_iter = xcb_randr_get_monitors_monitors_iterator(monitors_r);
+                    !used && monitor_iter.rem; xcb_randr_monitor_info_next(&monitor_iter))
+            {
+                xcb_randr_output_t *monitor_outputs = xcb_randr_monitor_info_outputs(monitor_iter.data);
+                for(int k = 0; k < xcb_randr_monitor_info_outputs_length(monitor_iter.data); k++)
+                    if(monitor_outputs[k] == crtc_outputs[j])
+                        used = true;
+            }
+
+        if(used)
+            refresh_rate = MAX(refresh_rate, screen_mode_refresh_rate(modes, num_modes, crtc->mode));
+        p_delete(&crtc);
+    }
+
+    p_delete(&crtc_info_c);
+    p_delete(&screen_res_r);
+    return refresh_rate;
+}
+
 static void
 screen_scan_randr_monitors(lua_State *L, screen_array_t *screens)
 {
     xcb_randr_get_monitors_cookie_t monitors_c = xcb_randr_get_monitors(globalconf.connection, globalconf.screen->root, 1);
+    /* Only needed for the refresh rate, but sent now to save a round-trip */
+    xcb_randr_get_screen_resources_current_cookie_t screen_res_c =
+        xcb_randr_get_screen_resources_current(globalconf.connection, globalconf.screen->root);
     xcb_randr_get_monitors_reply_t *monitors_r = xcb_randr_get_monitors_reply(globalconf.connection, monitors_c, NULL);
     xcb_randr_monitor_info_iterator_t monitor_iter;
 
     if (monitors_r == NULL) {
         warn("RANDR GetMonitors failed; this should not be possible");
+        xcb_discard_reply(globalconf.connection, screen_res_c.sequence);
         return;
     }
 
+    /* Ask for all the monitor names before waiting for any of them */
+    int num_monitors = xcb_randr_get_monitors_monitors_length(monitors_r);
+    xcb_get_atom_name_cookie_t *name_c = p_new(xcb_get_atom_name_cookie_t, num_monitors);
+    int monitor_idx = 0;
+
+    for(monitor_iter = xcb_randr_get_monitors_monitors_iterator(monitors_r);
+            monitor_iter.rem; xcb_randr_monitor_info_next(&monitor_iter))
+        name_c[monitor_idx++] = xcb_get_atom_name_unchecked(globalconf.connection, monitor_iter.data->name);
+
+    monitor_idx = 0;
     for(monitor_iter = xcb_randr_get_monitors_monitors_iterator(monitors_r);
             monitor_iter.rem; xcb_randr_monitor_info_next(&monitor_iter))
     {
         screen_t *new_screen;
         screen_output_t output;
         xcb_randr_output_t *randr_outputs;
-        xcb_get_atom_name_cookie_t name_c;
         xcb_get_atom_name_reply_t *name_r;
 
+        name_r = xcb_get_atom_name_reply(globalconf.connection, name_c[monitor_idx++], NULL);
+
         if(!xcb_randr_monitor_info_outputs_length(monitor_iter.data))
+        {
+            p_delete(&name_r);
             continue;
+        }
 
         new_screen = screen_add(L, screens);
         new_screen->geometry.x = monitor_iter.data->x;
@@ -309,8 +416,6 @@ screen_scan_randr_monitors(lua_State *L, screen_array_t *screens)
         output.mm_width = monitor_iter.data->width_in_millimeters;
         output.mm_height = monitor_iter.data->height_in_millimeters;
 
-        name_c = xcb_get_atom_name_unchecked(globalconf.connection, monitor_iter.data->name);
-        name_r = xcb_get_atom_name_reply(globalconf.connection, name_c, NULL);
         if (name_r) {
             const char *name = xcb_get_atom_name_name(name_r);
             size_t len = xcb_get_atom_name_name_length(name_r);
@@ -331,6 +436,10 @@ screen_scan_randr_monitors(lua_State *L, screen_array_t *screens)
         screen_output_array_append(&new_screen->outputs, output);
     }
 
+    /* Pace our redraws to the fastest monitor */
+    globalconf.refresh_rate = screen_monitors_refresh_rate(screen_res_c, monitors_r);
+
+    p_delete(&name_c);
     p_delete(&monitors_r);
 }
 #else
@@ -340,8 +449,19 @@ screen_scan_randr_monitors(lua_State *L, screen_array_t *screens)
 }
 #endif
 
-static void
-screen_scan_randr_crtcs(lua_State *L, screen_array_t *screens)
+/** Scan the CRTCs through RandR 1.2+.
+ * All GetCrtcInfo requests are sent before waiting for the first reply, and
+ * the same is done for the GetOutputInfo requests, so that a scan costs three
+ * round-trips independently of the number of CRTCs and outputs.
+ * \param L The Lua VM state.
+ * \param screens The array to fill with the new screens.
+ * \param if_changed Only scan if the configuration timestamps changed since
+ *        the last scan.
+ * \return False if nothing was scanned, either because the configuration did
+ *         not change or because it is unusable.
+ */
+static bool
+screen_scan_randr_crtcs(lua_State *L, screen_array_t *screens, bool if_changed)
 {
     /* A quick XRandR recall:
      * You have CRTC that manages a part of a SCREEN.
@@ -351,41 +471,98 @@ screen_scan_randr_crtcs(lua_State *L, screen_array_t *screens)
 
     if (screen_res_r == NULL) {
         warn("RANDR GetScreenResources failed; this should not be possible");
-        return;
+        return false;
     }
 
-    /* We go through CRTC, and build a screen for each one. */
+    /* The server bumps these timestamps on every configuration change, so
+     * there is no need to look at the CRTCs again if they did not move. */
+    if (if_changed
+            && screen_res_r->timestamp == globalconf.randr_timestamp
+            && screen_res_r->config_timestamp == globalconf.randr_config_timestamp)
+    {
+        p_delete(&screen_res_r);
+        return false;
+    }
+
+    xcb_timestamp_t config_timestamp = screen_res_r->config_timestamp;
+    int num_crtcs = screen_res_r->num_crtcs;
     xcb_randr_crtc_t *randr_crtcs = xcb_randr_get_screen_resources_crtcs(screen_res_r);
+    xcb_randr_get_crtc_info_cookie_t *crtc_info_c = p_new(xcb_randr_get_crtc_info_cookie_t, num_crtcs);
+    xcb_randr_get_crtc_info_reply_t **crtc_info_r = p_new(xcb_randr_get_crtc_info_reply_t *, num_crtcs);
+    int num_outputs = 0;
 
-    for(int i = 0; i < screen_res_r->num_crtcs; i++)
-    {
-        /* Get info on the output crtc */
-        xcb_randr_get_crtc_info_cookie_t crtc_info_c = xcb_randr_get_crtc_info(globalconf.connection, randr_crtcs[i], XCB_CURRENT_TIME);
-        xcb_randr_get_crtc_info_reply_t *crtc_info_r = xcb_randr_get_crtc_info_reply(globalconf.connection, crtc_info_c, NULL);
+    /* Ask for all CRTCs at once... */
+    for(int i = 0; i < num_crtcs; i++)
+        crtc_info_c[i] = xcb_randr_get_crtc_info(globalconf.connection, randr_crtcs[i], config_timestamp);
 
-        if(!crtc_info_r) {
+    /* ...then collect the answers and ask for all the outputs at once */
+    for(int i = 0; i < num_crtcs; i++)
+    {
+        crtc_info_r[i] = xcb_randr_get_crtc_info_reply(globalconf.connection, crtc_info_c[i], NULL);
+        if(!crtc_info_r[i])
             warn("RANDR GetCRTCInfo failed; this should not be possible");
+        else
+            num_outputs += xcb_randr_get_crtc_info_outputs_length(crtc_info_r[i]);
+    }
+
+    xcb_randr_get_output_info_cookie_t *output_info_c = p_new(xcb_randr_get_output_info_cookie_t, num_outputs);
+    int output_idx = 0;
+
+    for(int i = 0; i < num_crtcs; i++)
+    {
+        if(!crtc_info_r[i])
             continue;
-        }
+
+        xcb_randr_output_t *randr_outputs = xcb_randr_get_crtc_info_outputs(crtc_info_r[i]);
+        for(int j = 0; j < xcb_randr_get_crtc_info_outputs_length(crtc_info_r[i]); j++)
+            output_info_c[output_idx++] = xcb_randr_get_output_info(globalconf.connection, randr_outputs[j], config_timestamp);
+    }
+
+    /* We go through CRTC, and build a screen for each one. */
+    bool compat_layer = false;
+    double refresh_rate = 0;
+    output_idx = 0;
+
+    for(int i = 0; i < num_crtcs; i++)
+    {
+        xcb_randr_get_crtc_info_reply_t *crtc = crtc_info_r[i];
 
         /* If CRTC has no OUTPUT, ignore it */
-        if(!xcb_randr_get_crtc_info_outputs_length(crtc_info_r))
+        if(!crtc || !xcb_randr_get_crtc_info_outputs_length(crtc))
             continue;
 
+        /* Pace our redraws to the fastest monitor */
+        refresh_rate = MAX(refresh_rate, screen_mode_refresh_rate(
+                    xcb_randr_get_screen_resources_modes(screen_res_r),
+                    xcb_randr_get_screen_resources_modes_length(screen_res_r),
+                    crtc->mode));
+
         /* Prepare the new screen */
-        screen_t *new_screen = screen_add(L, screens);
-        new_screen->geometry.x = crtc_info_r->x;
-        new_screen->geometry.y = crtc_info_r->y;
-        new_screen->geometry.width= crtc_info_r->width;
-        new_screen->geometry.height= crtc_info_r->height;
-        new_screen->xid = randr_crtcs[i];
+        screen_t *new_screen = NULL;
+        if(!compat_layer)
+        {
+            new_screen = screen_add(L, screens);
+            new_screen->geometry.x = crtc->x;
+            new_screen->geometry.y = crtc->y;
+            new_screen->geometry.width= crtc->width;
+            new_screen->geometry.height= crtc->height;
+            new_screen->xid = randr_crtcs[i];
+        }
 
-        xcb_randr_output_t *randr_outputs = xcb_randr_get_crtc_info_outputs(crtc_info_r);
+        xcb_randr_output_t *randr_outputs = xcb_randr_get_crtc_info_outputs(crtc);
 
-        for(int j = 0; j < xcb_randr_get_crtc_info_outputs_length(crtc_info_r); j++)
+        for(int j = 0; j < xcb_randr_get_crtc_info_outputs_length(crtc); j++)
         {
-            xcb_randr_get_output_info_cookie_t output_info_c = xcb_randr_get_output_info(globalconf.connection, randr_outputs[j], XCB_CURRENT_TIME);
-            xcb_randr_get_output_info_reply_t *output_info_r = xcb_randr_get_output_info_reply(globalconf.connection, output_info_c, NULL);
+            xcb_randr_get_output_info_cookie_t cookie = output_info_c[output_idx++];
+
+            /* Still eat the replies we asked for, but ignore them */
+            if(compat_layer)
+            {
+                xcb_discard_reply(globalconf.connection, cookie.sequence);
+                continue;
+            }
+
+            xcb_randr_get_output_info_reply_t *output_info_r = xcb_randr_get_output_info_reply(globalconf.connection, cookie, NULL);
             screen_output_t output;
 
             if (!output_info_r) {
@@ -406,7 +583,6 @@ screen_scan_randr_crtcs(lua_State *L, screen_array_t *screens)
 
             screen_output_array_append(&new_screen->outputs, output);
 
-
             p_delete(&output_info_r);
 
             if (A_STREQ(name, "default"))
@@ -422,14 +598,29 @@ screen_scan_randr_crtcs(lua_State *L, screen_array_t *screens)
                 screen_array_wipe(screens);
                 screen_array_init(screens);
 
-                return;
+                compat_layer = true;
             }
         }
+    }
+
+    for(int i = 0; i < num_crtcs; i++)
+        p_delete(&crtc_info_r[i]);
+    p_delete(&crtc_info_r);
+    p_delete(&crtc_info_c);
+    p_delete(&output_info_c);
 
-        p_delete(&crtc_info_r);
+    if(compat_layer)
+    {
+        globalconf.randr_timestamp = globalconf.randr_config_timestamp = XCB_CURRENT_TIME;
+        p_delete(&screen_res_r);
+        return false;
     }
 
+    globalconf.randr_timestamp = screen_res_r->timestamp;
+    globalconf.randr_config_timestamp = config_timestamp;
+    globalconf.refresh_rate = refresh_rate;
     p_delete(&screen_res_r);
+    return true;
 }
 
 static void
@@ -474,7 +665,7 @@ screen_scan_randr(lua_State *L, screen_array_t *screens)
     if (globalconf.have_randr_15)
         screen_scan_randr_monitors(L, screens);
     else
-        screen_scan_randr_crtcs(L, screens);
+        screen_scan_randr_crtcs(L, screens, false);
 
     if (screens->len == 0)
     {
@@ -646,53 +837,88 @@ screen_refresh(void)
     screen_array_init(&new_screens);
     if (globalconf.have_randr_15)
         screen_scan_randr_monitors(L, &new_screens);
-    else
-        screen_scan_randr_crtcs(L, &new_screens);
+    else if (!screen_scan_randr_crtcs(L, &new_screens, true))
+    {
+        /* The CRTC configuration did not change, only the primary output
+         * might have */
+        screen_update_primary();
+        return;
+    }
 
     screen_deduplicate(L, &new_screens);
 
-    /* Add new screens */
-    foreach(new_screen, new_screens) {
-        bool found = false;
-        foreach(old_screen, globalconf.screens)
-            found |= (*new_screen)->xid == (*old_screen)->xid;
-        if(!found) {
-            screen_array_append(&globalconf.screens, *new_screen);
-            screen_added(L, *new_screen);
-            /* Get an extra reference since both new_screens and
-             * globalconf.screens reference this screen now */
-            luaA_object_push(L, *new_screen);
-            luaA_object_ref(L, -1);
+    /* Pair each new screen with the existing screen with the same XID, so that
+     * unchanged screens can be left alone below */
+    screen_t **matches = p_new(screen_t *, new_screens.len);
+    int old_len = globalconf.screens.len;
+    bool *old_matched = p_new(bool, old_len);
+    for(int i = 0; i < new_screens.len; i++)
+        for(int j = 0; j < old_len; j++)
+            if(!old_matched[j] && new_screens.tab[i]->xid == globalconf.screens.tab[j]->xid)
+            {
+                matches[i] = globalconf.screens.tab[j];
+                old_matched[j] = true;
+                break;
+            }
 
-            list_changed = true;
+    /* Remember the screens which are gone before calling into Lua, since the
+     * signal handlers might add or remove screens themselves. Keep them
+     * referenced so that they can still be told apart from new screens. */
+    screen_array_t gone;
+    screen_array_init(&gone);
+    for(int i = 0; i < old_len; i++)
+        if(!old_matched[i])
+        {
+            screen_array_append(&gone, globalconf.screens.tab[i]);
+            luaA_object_push(L, globalconf.screens.tab[i]);
+            luaA_object_ref(L, -1);
         }
+    p_delete(&old_matched);
+
+    /* Add new screens */
+    for(int i = 0; i < new_screens.len; i++) {
+        if(matches[i])
+            continue;
+
+        screen_t *new_screen = new_screens.tab[i];
+        screen_array_append(&globalconf.screens, new_screen);
+        screen_added(L, new_screen);
+        /* Get an extra reference since both new_screens and
+         * globalconf.screens reference this screen now */
+        luaA_object_push(L, new_screen);
+        luaA_object_ref(L, -1);
+
+        list_changed = true;
     }
 
-    /* Remove screens which are gone */
-    for(int i = 0; i < globalconf.screens.len; i++) {
-        screen_t *old_screen = globalconf.screens.tab[i];
-        bool found = false;
-        foreach(new_screen, new_screens)
-            found |= (*new_screen)->xid == old_screen->xid;
-        if(!found) {
-            screen_array_take(&globalconf.screens, i);
-            i--;
+    /* Remove screens which are gone. Their position is looked up again, as
+     * it changes with every removal and with what the handlers did. */
+    foreach(old_screen, gone) {
+        int idx = screen_get_index(*old_screen) - 1;
+        if(idx < 0)
+            /* Already removed with fake_remove() */
+            continue;
 
-            luaA_object_push(L, old_screen);
-            screen_removed(L, -1);
-            lua_pop(L, 1);
-            luaA_object_unref(L, old_screen);
-            old_screen->valid = false;
+        screen_array_take(&globalconf.screens, idx);
 
-            list_changed = true;
-        }
+        luaA_object_push(L, *old_screen);
+        screen_removed(L, -1);
+        lua_pop(L, 1);
+        luaA_object_unref(L, *old_screen);
+        (*old_screen)->valid = false;
+
+        list_changed = true;
     }
+    foreach(old_screen, gone)
+        luaA_object_unref(L, *old_screen);
+    screen_array_wipe(&gone);
 
-    /* Update changed screens */
-    foreach(existing_screen, globalconf.screens)
-        foreach(new_screen, new_screens)
-            if((*existing_screen)->xid == (*new_screen)->xid)
-                screen_modified(*existing_screen, *new_screen);
+    /* Update changed screens, screen_modified() only emits signals for what
+     * really differs */
+    for(int i = 0; i < new_screens.len; i++)
+        if(matches[i] && screen_get_index(matches[i]) > 0)
+            screen_modified(matches[i], new_screens.tab[i]);
+    p_delete(&matches);
 
     foreach(screen, new_screens)
         luaA_object_unref(L, *screen);
@@ -790,11 +1016,19 @@ screen_area_in_screen(screen_t *s, area_t geom)
                && (geom.y + geom.height > s->geometry.y);
 }
 
-void screen_update_workarea(screen_t *screen)
+/** Recompute the workarea of a screen from the registered strut providers.
+ * This does not call into Lua, so that it can be used from property getters.
+ * The change is announced by screen_refresh_workarea().
+ * \param screen The screen.
+ */
+static void
+screen_compute_workarea(screen_t *screen)
 {
     area_t area = screen->geometry;
     uint16_t top = 0, bottom = 0, left = 0, right = 0;
 
+    screen->workarea_dirty = false;
+
 #define COMPUTE_STRUT(o) \
     { \
         if((o)->strut.top_start_x || (o)->strut.top_end_x || (o)->strut.top) \
@@ -827,11 +1061,11 @@ void screen_update_workarea(screen_t *screen)
         } \
     }
 
-    foreach(c, globalconf.clients)
+    foreach(c, globalconf.strut_clients)
         if((*c)->screen == screen && client_isvisible(*c))
             COMPUTE_STRUT(*c)
 
-    foreach(drawin, globalconf.drawins)
+    foreach(drawin, globalconf.strut_drawins)
         if((*drawin)->visible)
         {
             screen_t *d_screen =
@@ -850,13 +1084,158 @@ void screen_update_workarea(screen_t *screen)
     if (AREA_EQUAL(area, screen->workarea))
         return;
 
-    area_t old_workarea = screen->workarea;
+    if(!screen->workarea_changed)
+    {
+        screen->old_workarea = screen->workarea;
+        screen->workarea_changed = true;
+    }
     screen->workarea = area;
+}
+
+/** Mark the workarea of a screen as needing a recomputation. This is done
+ * once per main loop iteration by screen_refresh_workarea().
+ * \param screen The screen, may be NULL.
+ */
+void
+screen_update_workarea(screen_t *screen)
+{
+    if(screen)
+        screen->workarea_dirty = true;
+}
+
+/** Recompute the workarea of all screens which need it and emit
+ * property::workarea for the ones which changed.
+ * \return True if any workarea changed.
+ */
+static bool
+screen_refresh_workarea_once(void)
+{
     lua_State *L = globalconf_get_lua_State();
-    luaA_object_push(L, screen);
-    luaA_pusharea(L, old_workarea);
-    luaA_object_emit_signal(L, -2, "property::workarea", 1);
-    lua_pop(L, 1);
+    bool changed = false;
+
+    /* The signal handlers might modify the screen list */
+    for(int i = 0; i < globalconf.screens.len; i++)
+    {
+        screen_t *screen = globalconf.screens.tab[i];
+
+        if(screen->workarea_dirty)
+            screen_compute_workarea(screen);
+        if(!screen->workarea_changed)
+            continue;
+
+        screen->workarea_changed = false;
+        if(AREA_EQUAL(screen->old_workarea, screen->workarea))
+            continue;
+
+        luaA_object_push(L, screen);
+        luaA_pusharea(L, screen->old_workarea);
+        luaA_object_emit_signal(L, -2, "property::workarea", 1);
+        lua_pop(L, 1);
+        changed = true;
+    }
+
+    return changed;
+}
+
+/** Recompute the workareas which need it, once per main loop iteration.
+ * property::workarea handlers usually queue more deferred Lua work, which may
+ * move struts again, so the refresh is repeated until the workareas settle.
+ * Handlers which keep changing them only get a few passes, the rest is left
+ * to the next iteration.
+ */
+void
+screen_refresh_workarea(void)
+{
+    for(int pass = 0; pass < WORKAREA_REFRESH_MAX_PASSES; pass++)
+    {
+        if(!screen_refresh_workarea_once())
+            return;
+        luaA_emit_refresh();
+    }
+
+    warn("The workarea is still changing after %d passes, "
+         "property::workarea handlers might be changing struts in a loop",
+         WORKAREA_REFRESH_MAX_PASSES);
+}
+
+/** Update the strut providers registry after a change to a client's strut.
+ * \param c The client.
+ */
+void
+screen_strut_client_update(client_t *c)
+{
+    bool provider = c->window != XCB_NONE && strut_has_value(&c->strut);
+    bool registered = false;
+
+    foreach(elem, globalconf.strut_clients)
+        if(*elem == c)
+        {
+            if(!provider)
+                client_array_remove(&globalconf.strut_clients, elem);
+            registered = true;
+            break;
+        }
+
+    if(provider && !registered)
+        client_array_append(&globalconf.strut_clients, c);
+
+    if(provider || registered)
+        screen_update_workarea(c->screen);
+}
+
+/** Remove a client from the strut providers registry.
+ * \param c The client.
+ */
+void
+screen_strut_client_remove(client_t *c)
+{
+    foreach(elem, globalconf.strut_clients)
+        if(*elem == c)
+        {
+            client_array_remove(&globalconf.strut_clients, elem);
+            screen_update_workarea(c->screen);
+            break;
+        }
+}
+
+/** Update the strut providers registry after a change to a drawin's strut.
+ * \param w The drawin.
+ */
+void
+screen_strut_drawin_update(drawin_t *w)
+{
+    bool provider = strut_has_value(&w->strut);
+    bool registered = false;
+
+    foreach(elem, globalconf.strut_drawins)
+        if(*elem == w)
+        {
+            if(!provider)
+                drawin_array_remove(&globalconf.strut_drawins, elem);
+            registered = true;
+            break;
+        }
+
+    if(provider && !registered)
+        drawin_array_append(&globalconf.strut_drawins, w);
+
+    if(provider || registered)
+        screen_update_workarea(screen_getbycoord(w->geometry.x, w->geometry.y));
+}
+
+/** Remove a drawin from the strut providers registry.
+ * \param w The drawin.
+ */
+void
+screen_strut_drawin_remove(drawin_t *w)
+{
+    foreach(elem, globalconf.strut_drawins)
+        if(*elem == w)
+        {
+            drawin_array_remove(&globalconf.strut_drawins, elem);
+            screen_update_workarea(screen_getbycoord(w->geometry.x, w->geometry.y));
+            break;
+        }
 }
 
 /** Get display info.
@@ -895,6 +1274,12 @@ screen_client_moveto(client_t *c, screen_t *new_screen, bool doresize)
 
     c->screen = new_screen;
 
+    if(strut_has_value(&c->strut))
+    {
+        screen_update_workarea(old_screen);
+        screen_update_workarea(new_screen);
+    }
+
     if(!doresize)
     {
         luaA_object_push(L, c);
@@ -1094,10 +1479,44 @@ luaA_screen_get_outputs(lua_State *L, screen_t *s)
 static int
 luaA_screen_get_workarea(lua_State *L, screen_t *s)
 {
+    if(s->workarea_dirty)
+        screen_compute_workarea(s);
     luaA_pusharea(L, s->workarea);
     return 1;
 }
 
+/** Get the screen geometry without creating a table.
+ *
+ * @treturn integer The x coordinate.
+ * @treturn integer The y coordinate.
+ * @treturn integer The width.
+ * @treturn integer The height.
+ * @function unpacked_geometry
+ */
+static int
+luaA_screen_unpacked_geometry(lua_State *L)
+{
+    screen_t *s = luaA_checkudata(L, 1, &screen_class);
+    return luaA_pusharea_unpacked(L, s->geometry);
+}
+
+/** Get the screen workarea without creating a table.
+ *
+ * @treturn integer The x coordinate.
+ * @treturn integer The y coordinate.
+ * @treturn integer The width.
+ * @treturn integer The height.
+ * @function unpacked_workarea
+ */
+static int
+luaA_screen_unpacked_workarea(lua_State *L)
+{
+    screen_t *s = luaA_checkudata(L, 1, &screen_class);
+    if(s->workarea_dirty)
+        screen_compute_workarea(s);
+    return luaA_pusharea_unpacked(L, s->workarea);
+}
+
 /** Get the number of screens.
  *
  * @return The screen count, at least 1.
@@ -1266,6 +1685,8 @@ screen_class_setup(lua_State *L)
         { "fake_remove", luaA_screen_fake_remove },
         { "fake_resize", luaA_screen_fake_resize },
         { "swap", luaA_screen_swap },
+        { "unpacked_geometry", luaA_screen_unpacked_geometry },
+        { "unpacked_workarea", luaA_screen_unpacked_workarea },
         { NULL, NULL },
     };
 
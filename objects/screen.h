@@ -39,6 +39,12 @@ struct a_screen
     area_t geometry;
     /** Screen workarea */
     area_t workarea;
+    /** Does the workarea need to be recomputed? */
+    bool workarea_dirty;
+    /** Workarea before the changes not yet announced to Lua */
+    area_t old_workarea;
+    /** Is there a property::workarea signal to emit? */
+    bool workarea_changed;
     /** The screen outputs informations */
     screen_output_array_t outputs;
     /** Some XID identifying this screen */
@@ -56,6 +62,10 @@ area_t display_area_get(void);
 void screen_client_moveto(client_t *, screen_t *, bool);
 void screen_update_primary(void);
 void screen_update_workarea(screen_t *);
+void screen_strut_client_update(client_t *);
+void screen_strut_client_remove(client_t *);
+void screen_strut_drawin_update(drawin_t *);
+void screen_strut_drawin_remove(drawin_t *);
 screen_t *screen_get_primary(void);
 
 screen_t *luaA_checkscreen(lua_State *, int);
@@ -325,7 +325,8 @@ tag_client(lua_State *L, client_t *c)
     client_array_append(&t->clients, c);
     ewmh_client_update_desktop(c);
     banning_need_update();
-    screen_update_workarea(c->screen);
+    if(strut_has_value(&c->strut))
+        screen_update_workarea(c->screen);
 
     tag_client_emit_signal(t, c, "tagged");
 }
@@ -344,7 +345,8 @@ untag_client(client_t *c, tag_t *t)
             client_array_take(&t->clients, i);
             banning_need_update();
             ewmh_client_update_desktop(c);
-            screen_update_workarea(c->screen);
+            if(strut_has_value(&c->strut))
+                screen_update_workarea(c->screen);
             tag_client_emit_signal(t, c, "untagged");
             luaA_object_unref(L, t);
             return;
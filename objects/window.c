@@ -55,6 +55,8 @@
 #include "common/atoms.h"
 #include "common/xutil.h"
 #include "ewmh.h"
+#include "objects/client.h"
+#include "objects/drawin.h"
 #include "objects/screen.h"
 #include "property.h"
 #include "xwindow.h"
@@ -106,12 +108,15 @@ luaA_window_struts(lua_State *L)
 
     if(lua_gettop(L) == 2)
     {
+        lua_class_t *class = luaA_class_get(L, 1);
+
         luaA_tostrut(L, 2, &window->strut);
         ewmh_update_strut(window->window, &window->strut);
+        if(class == &client_class)
+            screen_strut_client_update((client_t *) window);
+        else if(class == &drawin_class)
+            screen_strut_drawin_update((drawin_t *) window);
         luaA_object_emit_signal(L, 1, "property::struts", 0);
-        /* We don't know the correct screen, update them all */
-        foreach(s, globalconf.screens)
-            screen_update_workarea(*s);
     }
 
     return luaA_pushstrut(L, window->strut);
@@ -297,30 +297,26 @@ luaA_root_keys(lua_State *L)
     {
         luaA_checktable(L, 1);
 
-        foreach(key, globalconf.keys)
-            luaA_object_unref(L, *key);
-
-        key_array_wipe(&globalconf.keys);
-        key_array_init(&globalconf.keys);
-
         lua_pushnil(L);
         while(lua_next(L, 1))
-            key_array_append(&globalconf.keys, luaA_object_ref_class(L, -1, &key_class));
+        {
+            luaA_checkudata(L, -1, &key_class);
+            lua_pop(L, 1);
+        }
 
+        key_set_t *old_keys = globalconf.keys;
+        globalconf.keys = luaA_key_set_new(L, 1);
+        key_set_unref(L, &old_keys);
+
+        /* Keys may have been changed in place, so always regrab. Only the
+         * grabs that differ are sent to the server. */
         xcb_screen_t *s = globalconf.screen;
-        xwindow_grabkeys(s->root, &globalconf.keys);
+        xwindow_grabkeys(s->root, globalconf.keys);
 
         return 1;
     }
 
-    lua_createtable(L, globalconf.keys.len, 0);
-    for(int i = 0; i < globalconf.keys.len; i++)
-    {
-        luaA_object_push(L, globalconf.keys.tab[i]);
-        lua_rawseti(L, -2, i + 1);
-    }
-
-    return 1;
+    return luaA_key_set_push(L, globalconf.keys);
 }
 
 /** Get or set global mouse bindings.
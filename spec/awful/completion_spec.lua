@@ -0,0 +1,63 @@
+local GLib = require("lgi").GLib
+local completion = require("awful.completion")
+
+describe("awful.completion.shell", function()
+    local dir
+    local getenv = os.getenv
+
+    local function touch(path)
+        local f = assert(io.open(path, "w"))
+        f:close()
+    end
+
+    setup(function()
+        dir = GLib.dir_make_tmp("completion_specXXXXXX")
+        touch(dir .. "/awesome-spec-a")
+        touch(dir .. "/awesome-spec-b")
+        touch(dir .. "/awesome-spec-data")
+        os.execute("chmod +x " .. dir .. "/awesome-spec-a " .. dir .. "/awesome-spec-b")
+        GLib.mkdir_with_parents(dir .. "/awesome-spec-dir", 448)
+
+        -- Only look for commands in the test directory
+        os.getenv = function(name) -- luacheck: ignore 122
+            if name == "PATH" then
+                return dir
+            end
+            return getenv(name)
+        end
+    end)
+
+    teardown(function()
+        os.getenv = getenv -- luacheck: ignore 122
+        os.remove(dir .. "/awesome-spec-a")
+        os.remove(dir .. "/awesome-spec-b")
+        os.remove(dir .. "/awesome-spec-data")
+        os.remove(dir .. "/awesome-spec-dir")
+        os.remove(dir)
+    end)
+
+    it("completes executables from PATH", function()
+        local command, _, matches = completion.shell("awesome-sp", 11, 1, "bash")
+        assert.is.equal("awesome-spec-a", command)
+        assert.is.same({ "awesome-spec-a", "awesome-spec-b" }, matches)
+
+        command = completion.shell("awesome-sp", 11, 2, "bash")
+        assert.is.equal("awesome-spec-b", command)
+    end)
+
+    it("picks up new executables", function()
+        touch(dir .. "/awesome-spec-c")
+        os.execute("chmod +x " .. dir .. "/awesome-spec-c")
+        local _, _, matches = completion.shell("awesome-sp", 11, 1, "bash")
+        os.remove(dir .. "/awesome-spec-c")
+        assert.is.same({ "awesome-spec-a", "awesome-spec-b", "awesome-spec-c" }, matches)
+    end)
+
+    it("completes file names", function()
+        local command = "ls " .. dir .. "/awesome-spec-d"
+        local _, _, matches = completion.shell(command, #command + 1, 1, "bash")
+        assert.is.same({ dir .. "/awesome-spec-data", dir .. "/awesome-spec-dir/" }, matches)
+    end)
+end)
+
+-- vim: filetype=lua:expandtab:shiftwidth=4:tabstop=8:softtabstop=4:textwidth=80
@@ -137,6 +137,56 @@ describe("gears.object", function()
         obj:emit_signal("signal")
     end)
 
+    it("calls callbacks in connection order", function()
+        local calls = {}
+        obj:connect_signal("signal", function() table.insert(calls, 1) end)
+        obj:weak_connect_signal("signal", function() table.insert(calls, 2) end)
+        obj:connect_signal("signal", function() table.insert(calls, 3) end)
+        obj:emit_signal("signal")
+        assert.is.same({ 1, 2, 3 }, calls)
+    end)
+
+    it("connecting twice calls once", function()
+        local count = 0
+        local function cb() count = count + 1 end
+        obj:connect_signal("signal", cb)
+        obj:connect_signal("signal", cb)
+        obj:emit_signal("signal")
+        assert.is.equal(1, count)
+    end)
+
+    it("connecting and disconnecting during emission", function()
+        local calls = {}
+        local function late() table.insert(calls, "late") end
+        local function second() table.insert(calls, "second") end
+        obj:connect_signal("signal", function()
+            table.insert(calls, "first")
+            obj:disconnect_signal("signal", second)
+            obj:connect_signal("signal", late)
+        end)
+        obj:connect_signal("signal", second)
+
+        -- Changes only apply to the next emission
+        obj:emit_signal("signal")
+        assert.is.same({ "first", "second" }, calls)
+
+        calls = {}
+        obj:emit_signal("signal")
+        assert.is.same({ "first", "late" }, calls)
+    end)
+
+    it("drops collected weak callbacks", function()
+        for _ = 1, 10 do
+            obj:weak_connect_signal("signal", function() end)
+        end
+        local called = false
+        obj:connect_signal("signal", function() called = true end)
+        collectgarbage("collect")
+        obj:emit_signal("signal")
+        assert.is_true(called)
+        assert.is.equal(1, obj._signals.signal.count)
+    end)
+
     it("dynamic property disabled", function()
         local class = {}
         function class:get_foo() return "bar" end
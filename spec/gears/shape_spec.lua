@@ -0,0 +1,42 @@
+local shape = require("gears.shape")
+
+describe("gears.shape", function()
+    describe("native_description", function()
+        it("describes plain shape functions", function()
+            assert.is.same({ shape = "rectangle" }, shape.native_description(shape.rectangle, 10, 20))
+            assert.is.same({ shape = "rounded_rect", radius = 10 },
+                           shape.native_description(shape.rounded_rect, 10, 20))
+            assert.is.same({ shape = "rounded_rect", radius = 10 },
+                           shape.native_description(shape.rounded_bar, 40, 20))
+            assert.is.same({ shape = "circle", radius = 5 }, shape.native_description(shape.circle, 10, 20))
+        end)
+
+        it("describes native shapes", function()
+            assert.is.same({ shape = "rounded_rect", radius = 4 },
+                           shape.native_description(shape.native("rounded_rect", 4), 10, 20))
+            assert.is.same({ shape = "partially_rounded_rect", tl = true, tr = false, br = true,
+                             bl = false, radius = 3 },
+                           shape.native_description(shape.native("partially_rounded_rect",
+                                                                 true, false, true, false, 3), 10, 20))
+        end)
+
+        it("ignores other shapes", function()
+            assert.is_nil(shape.native_description(shape.hexagon, 10, 20))
+            assert.is_nil(shape.native_description(function() end, 10, 20))
+        end)
+    end)
+
+    it("native shapes draw like the shape function", function()
+        local calls = {}
+        local cr = setmetatable({}, { __index = function(_, name)
+            return function(_, ...) table.insert(calls, { name, ... }) end
+        end })
+        shape.native("rounded_rect", 4)(cr, 10, 20)
+        local expected = calls
+        calls = {}
+        shape.rounded_rect(cr, 10, 20, 4)
+        assert.is.same(calls, expected)
+    end)
+end)
+
+-- vim: filetype=lua:expandtab:shiftwidth=4:tabstop=8:softtabstop=4:textwidth=80
@@ -4,9 +4,15 @@
 ---------------------------------------------------------------------------
 
 local os = os
+local io = io
 local string = string
+local GLib = require("lgi").GLib
 local icon_theme = require("menubar.icon_theme")
 
+-- Keep the on-disk cache out of the user's cache directory.
+local cache_file = os.tmpname()
+icon_theme.cache_file = cache_file
+
 local base_directories = {
     (os.getenv("SOURCE_DIRECTORY") or '.') .. "/spec/menubar/icons",
     (os.getenv("SOURCE_DIRECTORY") or '.') .. "/icons"
@@ -60,4 +66,58 @@ describe("menubar.icon_theme find_icon_path", function()
     end
 end)
 
+describe("menubar.icon_theme cache", function()
+    local dir
+
+    local function write(path, content)
+        local f = assert(io.open(path, "w"))
+        f:write(content)
+        f:close()
+    end
+
+    local function run_idle()
+        local context = GLib.MainContext.default()
+        while context:iteration(false) do end
+    end
+
+    setup(function()
+        dir = GLib.dir_make_tmp("icon_theme_specXXXXXX")
+        GLib.mkdir_with_parents(dir .. "/cached/16x16/apps", 448)
+        write(dir .. "/cached/index.theme",
+              "[Icon Theme]\nDirectories=16x16/apps\n\n[16x16/apps]\nSize=16\n")
+        write(dir .. "/cached/16x16/apps/old.png", "")
+    end)
+
+    teardown(function()
+        os.remove(dir .. "/cached/16x16/apps/old.png")
+        os.remove(dir .. "/cached/16x16/apps/new.png")
+        os.remove(dir .. "/cached/16x16/apps")
+        os.remove(dir .. "/cached/16x16")
+        os.remove(dir .. "/cached/index.theme")
+        os.remove(dir .. "/cached")
+        os.remove(dir)
+        os.remove(cache_file)
+    end)
+
+    it("picks up new icons after a refresh", function()
+        local obj = icon_theme("cached", { dir })
+        assert.is.same(dir .. "/cached/16x16/apps/old.png", obj:find_icon_path("old", 16))
+        assert.is_nil(obj:find_icon_path("new", 16))
+
+        write(dir .. "/cached/16x16/apps/new.png", "")
+        icon_theme.refresh_cache()
+        run_idle()
+
+        assert.is.same(dir .. "/cached/16x16/apps/new.png", obj:find_icon_path("new", 16))
+    end)
+
+    it("writes the directory listings to disk", function()
+        run_idle()
+        local f = assert(io.open(cache_file, "r"))
+        local content = f:read("*a")
+        f:close()
+        assert.is_not_nil(content:find("F\tnew.png\n", 1, true))
+    end)
+end)
+
 -- vim: filetype=lua:expandtab:shiftwidth=4:tabstop=8:softtabstop=4:textwidth=80
@@ -0,0 +1,77 @@
+local search = require("menubar.search")
+
+describe("menubar.search", function()
+    local entries = {
+        { name = "Firefox", cmdline = "firefox %u" },
+        { name = "GNU Image Manipulation Program", cmdline = "gimp-2.8 %U" },
+        { name = "Terminal", cmdline = "xterm" },
+        { name = "File Manager", cmdline = "thunar" },
+    }
+
+    local function names(index, query)
+        local ret = {}
+        for _, i in ipairs(index:query(query)) do
+            table.insert(ret, entries[i].name)
+        end
+        return ret
+    end
+
+    describe("score", function()
+        it("ranks prefix, word, substring and fuzzy matches", function()
+            local prefix = search.score("file manager", "file")
+            local word = search.score("file manager", "man")
+            local substring = search.score("file manager", "anag")
+            local fuzzy = search.score("file manager", "fmgr")
+            assert.is_true(prefix > word)
+            assert.is_true(word > substring)
+            assert.is_true(substring > fuzzy)
+        end)
+
+        it("prefers tight fuzzy matches", function()
+            assert.is_true(search.score("abcd", "ad") > search.score("axxxxd", "ad"))
+        end)
+
+        it("returns nil without match", function()
+            assert.is_nil(search.score("terminal", "z"))
+            assert.is_nil(search.score("terminal", "lt"))
+        end)
+    end)
+
+    describe("index", function()
+        it("matches everything with an empty query", function()
+            local index = search.new(entries)
+            assert.is.same({ "Firefox", "GNU Image Manipulation Program", "Terminal", "File Manager" },
+                           names(index, ""))
+        end)
+
+        it("matches names and command lines, ignoring case", function()
+            local index = search.new(entries)
+            assert.is.same({ "GNU Image Manipulation Program" }, names(index, "GIMP"))
+            assert.is.same({ "Terminal" }, names(index, "xterm"))
+        end)
+
+        it("refines and widens queries", function()
+            local index = search.new(entries)
+            assert.is.same({ "Firefox", "File Manager" }, names(index, "fi"))
+            assert.is.same({ "Firefox" }, names(index, "fir"))
+            assert.is.same({ "Firefox", "File Manager" }, names(index, "fi"))
+            assert.is.same({ "Terminal" }, names(index, "term"))
+        end)
+    end)
+
+    describe("sorted", function()
+        it("sorts lazily", function()
+            local items = { 5, 3, 9, 1, 7, 2 }
+            local sorted = search.sorted(items, function(a, b) return a < b end)
+            assert.is.equal(6, sorted:len())
+            assert.is.equal(1, sorted:get(1))
+            assert.is.equal(2, sorted:get(2))
+            assert.is.equal(9, sorted:get(6))
+            assert.is.equal(5, sorted:get(4))
+            assert.is_nil(sorted:get(7))
+            assert.is.equal(6, sorted:len())
+        end)
+    end)
+end)
+
+-- vim: filetype=lua:expandtab:shiftwidth=4:tabstop=8:softtabstop=4:textwidth=80
@@ -0,0 +1,116 @@
+local GLib = require("lgi").GLib
+
+-- menubar.utils needs wibox only to compute text widths, which is not tested
+-- here. The real module needs the C API.
+package.loaded["wibox"] = {}
+local utils = require("menubar.utils")
+
+-- Keep the on-disk cache out of the user's cache directory.
+local cache_file = os.tmpname()
+utils.desktop_cache_file = cache_file
+
+describe("menubar.utils.parse_dir", function()
+    local dir
+
+    local function write(path, content)
+        local f = assert(io.open(path, "w"))
+        f:write(content)
+        f:close()
+    end
+
+    local function entry(name)
+        return "[Desktop Entry]\nName=" .. name .. "\nExec=" .. name:lower() .. "\n"
+    end
+
+    -- Rewrite a file without changing its modification time.
+    local function rewrite(path, content)
+        os.execute("touch -r " .. path .. " " .. dir .. "/stamp")
+        write(path, content)
+        os.execute("touch -r " .. dir .. "/stamp " .. path)
+    end
+
+    local function run_idle()
+        local context = GLib.MainContext.default()
+        while context:iteration(false) do end
+    end
+
+    -- Parse the test directory and return the sorted names of the entries.
+    local function parse(module)
+        local result
+        module = module or utils
+        module.parse_dir(dir, function(programs) result = programs end)
+        local context = GLib.MainContext.default()
+        while not result do
+            context:iteration(true)
+        end
+        local names = {}
+        for _, program in ipairs(result) do
+            table.insert(names, program.Name)
+        end
+        table.sort(names)
+        return names
+    end
+
+    local function read_cache()
+        run_idle()
+        local f = assert(io.open(cache_file, "r"))
+        local content = f:read("*a")
+        f:close()
+        return content
+    end
+
+    setup(function()
+        dir = GLib.dir_make_tmp("menubar_utils_specXXXXXX")
+        write(dir .. "/stamp", "")
+        write(dir .. "/first.desktop", entry("First"))
+        write(dir .. "/second.desktop", entry("Second"))
+    end)
+
+    teardown(function()
+        os.remove(dir .. "/stamp")
+        os.remove(dir .. "/first.desktop")
+        os.remove(dir .. "/second.desktop")
+        os.remove(dir)
+        os.remove(cache_file)
+    end)
+
+    it("parses the .desktop files", function()
+        assert.is.same({ "First", "Second" }, parse())
+    end)
+
+    it("only reads the files which were modified", function()
+        rewrite(dir .. "/first.desktop", entry("Renamed"))
+        assert.is.same({ "First", "Second" }, parse())
+
+        os.execute("touch -d 2000-01-01 " .. dir .. "/first.desktop")
+        assert.is.same({ "Renamed", "Second" }, parse())
+    end)
+
+    it("writes the entries to the cache file", function()
+        local content = read_cache()
+        assert.is_not_nil(content:find("E\t" .. dir .. "/first.desktop\t", 1, true))
+        assert.is_not_nil(content:find("K\tName\tRenamed\n", 1, true))
+        assert.is_not_nil(content:find("K\tName\tSecond\n", 1, true))
+    end)
+
+    it("forgets about removed files", function()
+        os.remove(dir .. "/second.desktop")
+        assert.is.same({ "Renamed" }, parse())
+        assert.is_nil(read_cache():find("second.desktop", 1, true))
+    end)
+
+    it("starts from the cache file", function()
+        -- A new instance of the module only knows the cache file.
+        package.loaded["menubar.utils"] = nil
+        local fresh = require("menubar.utils")
+        fresh.desktop_cache_file = cache_file
+        finally(function()
+            package.loaded["menubar.utils"] = utils
+        end)
+
+        rewrite(dir .. "/first.desktop", entry("Uncached"))
+        assert.is.same({ "Renamed" }, parse(fresh))
+    end)
+end)
+
+-- vim: filetype=lua:expandtab:shiftwidth=4:tabstop=8:softtabstop=4:textwidth=80
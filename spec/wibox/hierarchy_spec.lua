@@ -259,6 +259,108 @@ describe("wibox.hierarchy", function()
             assert.is.same({ rect.x, rect.y, rect.width, rect.height }, { 4, 0, 5, 2 })
         end)
     end)
+
+    describe("cached drawing", function()
+        local cairo = require("lgi").cairo
+        local child, parent, instance, cr
+        local child_draws, parent_draws
+        local function nop() end
+
+        -- Draw a hierarchy and get the result as PNG data
+        local function render(h, context, width, height)
+            local img = cairo.ImageSurface(cairo.Format.ARGB32, width, height)
+            h:draw(context, cairo.Context(img))
+            img:flush()
+            local path = os.tmpname()
+            img:write_to_png(path)
+            local f = assert(io.open(path, "rb"))
+            local data = f:read("*a")
+            f:close()
+            os.remove(path)
+            return data
+        end
+
+        before_each(function()
+            child_draws, parent_draws = 0, 0
+            child = make_widget(nil)
+            child.draw = function(_, _, c)
+                child_draws = child_draws + 1
+                c:rectangle(0, 0, 2, 2)
+                c:fill()
+            end
+            parent = make_widget({
+                make_child(child, 10, 20, matrix.create_translate(3, 4))
+            })
+            parent.draw = function()
+                parent_draws = parent_draws + 1
+            end
+            parent._private.cached = true
+
+            instance = hierarchy.new({}, parent, 15, 30, nop, nop)
+            cr = cairo.Context(cairo.ImageSurface(cairo.Format.ARGB32, 15, 30))
+        end)
+
+        it("draws once", function()
+            instance:draw({}, cr)
+            instance:draw({}, cr)
+            assert.is.equal(1, parent_draws)
+            assert.is.equal(1, child_draws)
+            local bytes, count = hierarchy.get_cache_usage()
+            assert.is_true(bytes > 0)
+            assert.is_true(count > 0)
+        end)
+
+        it("redraws after a child changed", function()
+            instance:draw({}, cr)
+            child:emit_signal("widget::redraw_needed")
+            instance:draw({}, cr)
+            assert.is.equal(2, parent_draws)
+            assert.is.equal(2, child_draws)
+        end)
+
+        it("draws the same as without cache", function()
+            parent._private.cached = false
+            local direct = render(instance, {}, 15, 30)
+            parent._private.cached = true
+            assert.is.equal(direct, render(instance, {}, 15, 30))
+            assert.is.equal(direct, render(instance, {}, 15, 30))
+        end)
+
+        it("inherits the source of the parent", function()
+            local textbox = require("wibox.widget.textbox")("cached text")
+            local root = make_widget({
+                make_child(textbox, 60, 20, matrix.create_translate(2, 3))
+            })
+            local red, green = 1, 0
+            root.before_draw_children = function(_, _, c)
+                c:set_source_rgb(red, green, 0)
+            end
+            local context = { dpi = 96 }
+            local h = hierarchy.new(context, root, 64, 24, nop, nop)
+
+            textbox._private.cached = false
+            local direct_red = render(h, context, 64, 24)
+            textbox._private.cached = true
+            assert.is.equal(direct_red, render(h, context, 64, 24))
+            assert.is.equal(direct_red, render(h, context, 64, 24))
+
+            -- The parent changes its colour without touching the textbox
+            red, green = 0, 1
+            root:emit_signal("widget::redraw_needed")
+            local cached_green = render(h, context, 64, 24)
+            assert.is_not.equal(direct_red, cached_green)
+            textbox._private.cached = false
+            assert.is.equal(render(h, context, 64, 24), cached_green)
+        end)
+
+        it("is dropped when disabled", function()
+            instance:draw({}, cr)
+            parent._private.cached = false
+            instance:draw({}, cr)
+            assert.is.equal(2, parent_draws)
+            assert.is_nil(instance._cache)
+        end)
+    end)
 end)
 
 -- vim: filetype=lua:expandtab:shiftwidth=4:tabstop=8:softtabstop=4:textwidth=80
@@ -0,0 +1,96 @@
+local graph = require("wibox.widget.graph")
+local cairo = require("lgi").cairo
+
+describe("wibox.widget.graph", function()
+    -- Draw a graph and get the result as PNG data
+    local function render(widget, width, height)
+        local img = cairo.ImageSurface(cairo.Format.ARGB32, width, height)
+        local cr = cairo.Context(img)
+        widget:draw(nil, cr, width, height)
+        img:flush()
+
+        local path = os.tmpname()
+        img:write_to_png(path)
+        local f = assert(io.open(path, "rb"))
+        local data = f:read("*a")
+        f:close()
+        os.remove(path)
+        return data
+    end
+
+    local function sample(i)
+        return (i * 37 % 100) / 100
+    end
+
+    it("keeps only the values that fit", function()
+        local widget = graph { width = 10, height = 10 }
+        for i = 1, 25 do
+            widget:add_value(i / 25)
+        end
+        local values = widget._private.values
+        assert.is.equal(10, values.len)
+
+        -- The oldest values were dropped
+        widget:set_scale(true)
+        local full = render(widget, 10, 10)
+        local fresh = graph { width = 10, height = 10 }
+        fresh:set_scale(true)
+        for i = 16, 25 do
+            fresh:add_value(i / 25)
+        end
+        assert.is.equal(render(fresh, 10, 10), full)
+    end)
+
+    for _, args in ipairs {
+        { name = "lines" },
+        { name = "steps", step_width = 3, step_spacing = 1 },
+        { name = "a border", border_color = "#ffffff" },
+        { name = "scaling", scale = true },
+    } do
+        it("scrolls the previous rendering with " .. args.name, function()
+            local widget = graph { width = 50, height = 20 }
+            local reference = graph { width = 50, height = 20 }
+            for _, w in ipairs { widget, reference } do
+                w:set_step_width(args.step_width)
+                w:set_step_spacing(args.step_spacing)
+                w:set_border_color(args.border_color)
+                w:set_scale(args.scale)
+            end
+
+            for i = 1, 80 do
+                widget:add_value(sample(i))
+                if i % 7 == 0 then
+                    -- Only the new values get drawn
+                    render(widget, 50, 20)
+                end
+            end
+
+            for i = 1, 80 do
+                reference:add_value(sample(i))
+            end
+
+            assert.is.equal(render(reference, 50, 20), render(widget, 50, 20))
+        end)
+    end
+
+    it("draws directly when not aligned to whole pixels", function()
+        local widget = graph { width = 10, height = 10 }
+        for i = 1, 10 do
+            widget:add_value(sample(i))
+        end
+
+        for _, transform in ipairs { { 2, 2, 0, 0 }, { 1, 1, 0.5, 0 } } do
+            local cr = cairo.Context(cairo.ImageSurface(cairo.Format.ARGB32, 20, 20))
+            cr:translate(transform[3], transform[4])
+            cr:scale(transform[1], transform[2])
+            widget:draw(nil, cr, 10, 10)
+            assert.is_nil(widget._private.render_cache)
+        end
+
+        -- At whole pixels, the rendering is kept for the next draw
+        widget:draw(nil, cairo.Context(cairo.ImageSurface(cairo.Format.ARGB32, 10, 10)), 10, 10)
+        assert.is_not_nil(widget._private.render_cache)
+    end)
+end)
+
+-- vim: filetype=lua:expandtab:shiftwidth=4:tabstop=8:softtabstop=4:textwidth=80
@@ -27,9 +27,13 @@ local function _shim_fake_class()
     end
 
     function obj.emit_signal(name, c, ...)
-        local conns = obj._signals[name] or {strong={}}
-        for func in pairs(conns.strong) do
-            func(c, ...)
+        local conns = obj._signals[name] or {handlers={}, count=0}
+        for i = 1, conns.count do
+            -- Only strong connections are supported
+            local func = conns.handlers[i]
+            if type(func) == "function" then
+                func(c, ...)
+            end
         end
     end
 
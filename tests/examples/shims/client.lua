@@ -53,6 +53,10 @@ function client.gen_fake(args)
         }
     end
 
+    function ret:unpacked_geometry()
+        return ret.x, ret.y, ret.width, ret.height
+    end
+
     function ret:isvisible()
         return true
     end
@@ -17,6 +17,10 @@ function mouse.coords(args)
     return coords
 end
 
+function mouse.unpacked_coords()
+    return coords.x, coords.y
+end
+
 function mouse.push_history()
     table.insert(mouse.old_histories, mouse.history)
     mouse.history = {}
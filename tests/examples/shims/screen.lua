@@ -25,6 +25,14 @@ local function create_screen(args)
 
     local wa = args.workarea_sides or 10
 
+    function s:unpacked_geometry()
+        return geo.x or 0, geo.y or 0, geo.width, geo.height
+    end
+
+    function s:unpacked_workarea()
+        return (geo.x or 0) + wa, (geo.y or 0) + wa, geo.width - 2*wa, geo.height - 2*wa
+    end
+
     return setmetatable(s,{ __index = function(_, key)
         if key == "geometry" then
             return {
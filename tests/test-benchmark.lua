@@ -39,6 +39,20 @@ do
     end
 end
 
+-- Measure how much garbage a function creates, in KiB per call
+local function benchmark_garbage(f, msg)
+    local iters = BENCHMARK_EXACT and 100000 or 1000
+    collectgarbage("collect")
+    collectgarbage("stop")
+    local before = collectgarbage("count")
+    for _ = 1, iters do
+        f()
+    end
+    local garbage = (collectgarbage("count") - before) / iters
+    collectgarbage("restart")
+    print(string.format("%20s: %-10.6g KiB/iter (%d iters)", msg, garbage, iters))
+end
+
 local function do_pending_repaint()
     awesome.emit_signal("refresh")
 end
@@ -65,6 +79,104 @@ local function update_textclock()
     do_pending_repaint()
 end
 
+-- A synthetic corpus of menubar entries
+local menubar_entries = {}
+do
+    local words = { "audio", "browser", "calendar", "editor", "file", "game",
+                    "image", "mail", "manager", "music", "office", "player",
+                    "settings", "terminal", "video", "viewer" }
+    for i = 1, 10000 do
+        local a, b = words[i % #words + 1], words[(i * 7) % #words + 1]
+        table.insert(menubar_entries, {
+            name = string.format("%s %s %d", a, b, i),
+            cmdline = string.format("%s-%s%d --new-window", a, b, i),
+        })
+    end
+end
+
+local function menubar_typing()
+    local search = require("menubar.search")
+    local index = search.new(menubar_entries)
+    local query = "terminal vi"
+    for i = 1, #query do
+        local matches, scores = index:query(query:sub(1, i))
+        -- Sort the first page, like menubar does
+        local items = {}
+        for j, match in ipairs(matches) do
+            items[j] = match
+        end
+        local sorted = search.sorted(items, function(a, b) return scores[a] > scores[b] end)
+        for j = 1, 20 do
+            sorted:get(j)
+        end
+    end
+end
+
+local function screen_geometry_table()
+    local geo = screen.primary.geometry
+    return geo.x + geo.width
+end
+
+local function screen_geometry_unpacked()
+    local x, _, width = screen.primary:unpacked_geometry()
+    return x + width
+end
+
+local function mouse_coords_table()
+    local coords = mouse.coords()
+    return coords.x + coords.y
+end
+
+local function mouse_coords_unpacked()
+    local x, y = mouse.unpacked_coords()
+    return x + y
+end
+
+-- An object with a few callbacks for each kind of connection
+local signal_object = require("gears.object")()
+local signal_callbacks = {}
+for i = 1, 10 do
+    signal_callbacks[i] = function() end
+    if i % 2 == 0 then
+        signal_object:weak_connect_signal("widget::redraw_needed", signal_callbacks[i])
+    else
+        signal_object:connect_signal("widget::redraw_needed", signal_callbacks[i])
+    end
+end
+
+local function emit_object_signal()
+    for _ = 1, 100 do
+        signal_object:emit_signal("widget::redraw_needed")
+    end
+end
+
+local function reconnect_object_signal()
+    signal_object:disconnect_signal("widget::redraw_needed", signal_callbacks[1])
+    signal_object:connect_signal("widget::redraw_needed", signal_callbacks[1])
+end
+
+local cairo = require("lgi").cairo
+local sample_graph = require("wibox.widget.graph") { width = 200, height = 20 }
+local graph_cr = cairo.Context(cairo.ImageSurface(cairo.Format.ARGB32, 200, 20))
+local graph_sample = 0
+
+local function graph_add_and_draw()
+    graph_sample = graph_sample + 1
+    sample_graph:add_value(graph_sample * 37 % 100 / 100)
+    sample_graph:draw(nil, graph_cr, 200, 20)
+end
+
+local hit_wibox = create_wibox()
+-- Hidden wiboxes aren't laid out
+hit_wibox.visible = true
+do_pending_repaint()
+local hit_x = 0
+
+local function find_widgets_motion()
+    hit_x = (hit_x + 7) % 1024
+    return hit_wibox:find_widgets(hit_x, 10)
+end
+
 local function e2e_tag_switch()
     awful.tag.viewnext()
     do_pending_repaint()
@@ -75,6 +187,19 @@ benchmark(update_textclock, "update textclock")
 benchmark(relayout_textclock, "relayout textclock")
 benchmark(redraw_textclock, "redraw textclock")
 benchmark(e2e_tag_switch, "tag switch")
+benchmark(menubar_typing, "menubar search 10k")
+benchmark(graph_add_and_draw, "graph sample")
+benchmark(find_widgets_motion, "find_widgets")
+benchmark_garbage(find_widgets_motion, "find_widgets")
+benchmark(emit_object_signal, "emit signal x100")
+benchmark(reconnect_object_signal, "reconnect signal")
+benchmark_garbage(emit_object_signal, "emit signal x100")
+benchmark(screen_geometry_table, "screen.geometry")
+benchmark(screen_geometry_unpacked, "unpacked_geometry")
+benchmark_garbage(screen_geometry_table, "screen.geometry")
+benchmark_garbage(screen_geometry_unpacked, "unpacked_geometry")
+benchmark_garbage(mouse_coords_table, "mouse.coords")
+benchmark_garbage(mouse_coords_unpacked, "mouse.unpacked_coords")
 
 runner.run_steps({ function() return true end })
 
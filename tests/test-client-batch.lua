@@ -0,0 +1,74 @@
+-- Test that client.batch() coalesces the geometry signals of clients
+
+local runner = require("_runner")
+local test_client = require("_client")
+
+local signals = {}
+local function count(name)
+    return function(c)
+        signals[c] = signals[c] or {}
+        signals[c][name] = (signals[c][name] or 0) + 1
+    end
+end
+
+runner.run_steps({
+    function(count_)
+        if count_ == 1 then
+            test_client()
+        end
+        if #client.get() >= 1 then
+            return true
+        end
+    end,
+
+    function()
+        local c = client.get()[1]
+        c.floating = true
+        c:geometry { x = 10, y = 10, width = 100, height = 100 }
+
+        for _, name in ipairs { "geometry", "position", "size", "x", "y", "width", "height" } do
+            client.connect_signal("property::" .. name, count(name))
+        end
+
+        client.batch(function()
+            c:geometry { x = 20 }
+            c:geometry { y = 30 }
+            c:geometry { width = 200 }
+
+            -- Nothing is emitted yet, but the geometry is up to date
+            assert(not signals[c])
+            assert(c:geometry().x == 20)
+            assert(c:geometry().y == 30)
+            assert(c:geometry().width == 200)
+        end)
+
+        assert(signals[c].geometry == 1)
+        assert(signals[c].position == 1)
+        assert(signals[c].size == 1)
+
+        -- A change which is reverted inside the batch emits nothing
+        signals[c] = nil
+        client.batch(function()
+            c:geometry { x = 50 }
+            c:geometry { x = 20 }
+        end)
+        assert(not signals[c])
+
+        -- Errors are propagated and still end the batch
+        local ok, err = pcall(client.batch, function()
+            c:geometry { x = 60 }
+            error("oops")
+        end)
+        assert(not ok)
+        assert(err:find("oops") and err:find("traceback"), err)
+        assert(signals[c].geometry == 1)
+
+        signals[c] = nil
+        c:geometry { x = 70 }
+        assert(signals[c].geometry == 1)
+
+        return true
+    end,
+})
+
+-- vim: filetype=lua:expandtab:shiftwidth=4:tabstop=8:softtabstop=4:textwidth=80
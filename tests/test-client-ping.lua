@@ -0,0 +1,40 @@
+-- Test that c:kill(timeout) kills a client that stops answering _NET_WM_PING,
+-- after marking it as unresponsive
+
+local runner = require("_runner")
+local test_client = require("_client")
+
+local pid
+local unresponsive = false
+
+runner.run_steps({
+    function(count)
+        if count == 1 then
+            test_client()
+        end
+        local c = client.get()[1]
+        if c and c.pid then
+            pid = c.pid
+            return true
+        end
+    end,
+
+    -- A stopped client doesn't answer and gets killed
+    function(count)
+        if count == 1 then
+            local c = client.get()[1]
+            c:connect_signal("property::responsive", function()
+                unresponsive = not c.responsive
+            end)
+            awesome.kill(pid, awesome.unix_signal.SIGSTOP)
+            c:kill(0.2)
+            return
+        end
+        if #client.get() == 0 and unresponsive then
+            awesome.kill(pid, awesome.unix_signal.SIGKILL)
+            return true
+        end
+    end,
+})
+
+-- vim: filetype=lua:expandtab:shiftwidth=4:tabstop=8:softtabstop=4:textwidth=80
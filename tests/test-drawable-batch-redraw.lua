@@ -0,0 +1,84 @@
+-- Test that drawables are repainted together and that hidden ones wait
+-- until they are shown
+
+local runner = require("_runner")
+local wibox = require("wibox")
+local base = require("wibox.widget.base")
+
+local order = {}
+
+local function make_wibox(name, visible)
+    local widget = base.make_widget()
+    function widget:fit() return 10, 10 end
+    function widget:draw()
+        table.insert(order, name)
+    end
+
+    local w = wibox { x = 10, y = 10, width = 20, height = 20, visible = visible }
+    w:set_widget(widget)
+    return w, widget
+end
+
+local hidden = make_wibox("hidden", false)
+local shown, shown_widget = make_wibox("shown", true)
+local cr_before
+
+runner.run_steps({
+    -- Wait for the initial repaint, which skips the hidden wibox
+    function()
+        if #order >= 1 then
+            assert(#order == 1 and order[1] == "shown", table.concat(order, ", "))
+            return true
+        end
+    end,
+
+    function(count)
+        if count == 1 then
+            order = {}
+            hidden:set_bg("#ff0000")
+            shown:set_bg("#00ff00")
+            return
+        end
+
+        assert(#order == 1 and order[1] == "shown", table.concat(order, ", "))
+        return true
+    end,
+
+    -- Showing the hidden wibox repaints it once
+    function(count)
+        if count == 1 then
+            order = {}
+            hidden:set_bg("#0000ff")
+            hidden.visible = true
+            return
+        end
+
+        assert(#order == 1 and order[1] == "hidden", table.concat(order, ", "))
+        return true
+    end,
+
+    -- The cairo context is reused until the size changes
+    function(count)
+        if count == 1 then
+            order = {}
+            cr_before = shown._drawable._cr
+            assert(cr_before)
+            shown_widget:emit_signal("widget::redraw_needed")
+            return
+        end
+        if count == 2 then
+            assert(order[1] == "shown")
+            assert(shown._drawable._cr == cr_before)
+            shown.width = 30
+            return
+        end
+
+        if order[2] ~= "shown" then
+            return
+        end
+        assert(shown._drawable._cr ~= cr_before)
+        return true
+    end,
+})
+
+-- vim: filetype=lua:expandtab:shiftwidth=4:tabstop=8:softtabstop=4:textwidth=80
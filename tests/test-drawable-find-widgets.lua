@@ -0,0 +1,108 @@
+-- Test that drawable:find_widgets finds the same widgets as walking the
+-- widget hierarchy, also for rotated and scaled widgets
+
+local runner = require("_runner")
+local wibox = require("wibox")
+local matrix = require("gears.matrix")
+
+local w = wibox {
+    x = 10,
+    y = 10,
+    width = 100,
+    height = 20,
+    visible = true,
+}
+
+w:setup {
+    {
+        text = "plain",
+        forced_width = 30,
+        widget = wibox.widget.textbox,
+    },
+    {
+        {
+            text = "rotated",
+            widget = wibox.widget.textbox,
+        },
+        direction = "east",
+        forced_width = 20,
+        widget = wibox.container.rotate,
+    },
+    {
+        {
+            text = "mirrored",
+            widget = wibox.widget.textbox,
+        },
+        reflection = { horizontal = true },
+        forced_width = 30,
+        widget = wibox.container.mirror,
+    },
+    {
+        text = "last",
+        widget = wibox.widget.textbox,
+    },
+    layout = wibox.layout.fixed.horizontal,
+}
+
+-- The straightforward way to find the widgets under a point
+local function reference(result, h, x, y)
+    local x1, y1 = h:get_matrix_from_device():transform_point(x, y)
+    local x2, y2, w2, h2 = h:get_draw_extents()
+    if x1 < x2 or x1 >= x2 + w2 or y1 < y2 or y1 >= y2 + h2 then
+        return
+    end
+    local width, height = h:get_size()
+    if x1 >= 0 and y1 >= 0 and x1 <= width and y1 <= height then
+        local x3, y3, w3, h3 = matrix.transform_rectangle(h:get_matrix_to_device(),
+            0, 0, width, height)
+        table.insert(result, { widget = h:get_widget(), x = x3, y = y3, width = w3, height = h3 })
+    end
+    for _, child in ipairs(h:get_children()) do
+        reference(result, child, x, y)
+    end
+end
+
+local function check(x, y)
+    local expected = {}
+    reference(expected, w._drawable._widget_hierarchy, x, y)
+    local found = w:find_widgets(x, y)
+    assert(#found == #expected, string.format("%d ~= %d at %g, %g", #found, #expected, x, y))
+    for i, v in ipairs(found) do
+        local e = expected[i]
+        assert(v.widget == e.widget and v.drawable == w._drawable)
+        assert(v.x == e.x and v.y == e.y and v.width == e.width and v.height == e.height)
+    end
+end
+
+runner.run_steps({
+    function()
+        if not w._drawable._widget_hierarchy then
+            return
+        end
+
+        for x = -1, 101, 0.5 do
+            for y = -1, 21, 2.5 do
+                check(x, y)
+            end
+        end
+
+        -- The same entries are handed out again
+        assert(w:find_widgets(5, 5)[1] == w:find_widgets(5, 5)[1])
+
+        return true
+    end,
+
+    -- A relayout gives new results
+    function(count)
+        if count == 1 then
+            w.widget:get_children()[1].forced_width = 50
+            return
+        end
+
+        check(40, 5)
+        assert(w:find_widgets(40, 5)[2].widget == w.widget:get_children()[1])
+        return true
+    end,
+})
+
+-- vim: filetype=lua:expandtab:shiftwidth=4:tabstop=8:softtabstop=4:textwidth=80
@@ -0,0 +1,50 @@
+-- Test that awful.mouse.client.move starts a grab, with and without the
+-- native move/resize
+
+local runner = require("_runner")
+local test_client = require("_client")
+local awful = require("awful")
+
+runner.run_steps({
+    function(count)
+        if count == 1 then
+            test_client()
+        end
+        if #client.get() >= 1 then
+            return true
+        end
+    end,
+
+    function()
+        local c = client.get()[1]
+        c.floating = true
+
+        awful.mouse.native_moveresize = false
+        awful.mouse.client.move(c)
+        assert(mousegrabber.isrunning())
+        mousegrabber.stop()
+        assert(not mousegrabber.isrunning())
+
+        return true
+    end,
+
+    function()
+        local c = client.get()[1]
+        local geo = c:geometry()
+
+        awful.mouse.native_moveresize = true
+        awful.mouse.client.move(c, 10)
+        assert(mousegrabber.isrunning())
+        mousegrabber.stop()
+        assert(not mousegrabber.isrunning())
+
+        -- The pointer didn't move, neither did the client
+        local new_geo = c:geometry()
+        assert(new_geo.x == geo.x and new_geo.y == geo.y)
+
+        awful.mouse.native_moveresize = false
+        return true
+    end,
+})
+
+-- vim: filetype=lua:expandtab:shiftwidth=4:tabstop=8:softtabstop=4:textwidth=80
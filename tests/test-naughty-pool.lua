@@ -0,0 +1,65 @@
+-- Test that the popups of destroyed notifications are reused safely and that
+-- bursts are merged only when enabled
+
+local runner = require("_runner")
+local naughty = require("naughty")
+
+runner.run_steps({
+    -- A destroyed notification gives its popup to the next one
+    function()
+        local first = naughty.notify { title = "first", text = "one", timeout = 0 }
+        local box = first.box
+        assert(box and first.textbox)
+
+        assert(naughty.destroy(first))
+        assert(first.box == nil and first.textbox == nil)
+        assert(not box.visible)
+
+        local second = naughty.notify { title = "second", text = "two", timeout = 0 }
+        assert(second.box == box)
+        assert(second.box.visible)
+
+        -- Updating the destroyed notification must not touch the new one
+        naughty.replace_text(first, "stale", "stale")
+        local markup = second.textbox:get_markup()
+        assert(markup:find("two") and not markup:find("stale"), markup)
+
+        naughty.destroy(second)
+        return true
+    end,
+
+    -- Bursts are not merged by default, only once a limit is set
+    function()
+        local notifications = {}
+        for i = 1, 3 do
+            notifications[i] = naughty.notify { appname = "pool-test", text = "n" .. i, timeout = 0 }
+        end
+        assert(notifications[1] ~= notifications[2] and notifications[2] ~= notifications[3])
+        for _, n in ipairs(notifications) do
+            naughty.destroy(n)
+        end
+
+        local limit, interval = naughty.config.burst_limit, naughty.config.burst_interval
+        naughty.config.burst_limit = 2
+        naughty.config.burst_interval = 60
+
+        notifications = {}
+        for i = 1, 4 do
+            notifications[i] = naughty.notify { appname = "burst-test", text = "b" .. i, timeout = 0 }
+        end
+
+        naughty.config.burst_limit, naughty.config.burst_interval = limit, interval
+
+        assert(notifications[1] ~= notifications[2])
+        assert(notifications[3] == notifications[2])
+        assert(notifications[4] == notifications[2])
+        local markup = notifications[2].textbox:get_markup()
+        assert(markup:find("(+2)", 1, true) and markup:find("b4"), markup)
+
+        naughty.destroy(notifications[1])
+        naughty.destroy(notifications[2])
+        return true
+    end,
+})
+
+-- vim: filetype=lua:expandtab:shiftwidth=4:tabstop=8:softtabstop=4:textwidth=80
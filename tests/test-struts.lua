@@ -391,6 +391,48 @@ table.insert(steps, function()
     return true
 end)
 
+-- Add and remove drawin struts while the client one is still there
+table.insert(steps, function()
+    local geo = c.screen.geometry
+    local w1 = wibox { x = geo.x, y = geo.y, width = 30, height = 30, visible = true }
+    local w2 = wibox { x = geo.x, y = geo.y, width = 80, height = 30, visible = true }
+
+    w1:struts { left = 30 }
+    w2:struts { left = 80, top = 20 }
+    test_workarea(geo, c.screen.workarea, 80, 0, 20, 0)
+
+    -- Hidden drawins do not count, but stay registered
+    w2.visible = false
+    test_workarea(geo, c.screen.workarea, 50, 0, 0, 0)
+    w2.visible = true
+    test_workarea(geo, c.screen.workarea, 80, 0, 20, 0)
+
+    -- Removing the struts removes the drawins from the registry
+    w2:struts { left = 0, top = 0 }
+    test_workarea(geo, c.screen.workarea, 50, 0, 0, 0)
+    w1:struts { left = 0 }
+    w1.visible, w2.visible = false, false
+    test_workarea(geo, c.screen.workarea, 50, 0, 0, 0)
+
+    -- The client strut is still applied after its change
+    c:struts { left = 10, right = 40 }
+    test_workarea(geo, c.screen.workarea, 10, 40, 0, 0)
+
+    c:kill()
+    return true
+end)
+
+-- The strut of an unmanaged client no longer applies
+table.insert(steps, function()
+    if #client.get() ~= 0 then
+        return
+    end
+
+    test_workarea(screen.primary.geometry, screen.primary.workarea, 0, 0, 0, 0)
+
+    return true
+end)
+
 require("_runner").run_steps(steps)
 
 -- vim: filetype=lua:expandtab:shiftwidth=4:tabstop=8:softtabstop=4:textwidth=80
@@ -0,0 +1,87 @@
+-- Test that the titlebar of a banned client is only drawn again once the
+-- client is shown
+
+local runner = require("_runner")
+local test_client = require("_client")
+local awful = require("awful")
+local base = require("wibox.widget.base")
+
+local draws = 0
+local widget = base.make_widget()
+function widget:fit() return 10, 10 end
+function widget:draw()
+    draws = draws + 1
+end
+
+local titlebar
+local draws_on_unban
+
+runner.run_steps({
+    function(count)
+        if count == 1 then
+            test_client()
+        end
+        if #client.get() >= 1 then
+            return true
+        end
+    end,
+
+    function(count)
+        local c = client.get()[1]
+        if count == 1 then
+            titlebar = awful.titlebar(c)
+            titlebar:set_widget(widget)
+            return
+        end
+        if draws > 0 and not c.banned then
+            return true
+        end
+    end,
+
+    -- Move the client to a tag that isn't selected
+    function(count)
+        local c = client.get()[1]
+        if count == 1 then
+            c:move_to_tag(c.screen.tags[2])
+            return
+        end
+        if c.banned then
+            draws = 0
+            return true
+        end
+    end,
+
+    -- Changes while banned don't draw
+    function(count)
+        if count == 1 then
+            titlebar:set_bg("#ff0000")
+            widget:emit_signal("widget::layout_changed")
+            widget:emit_signal("widget::redraw_needed")
+            return
+        end
+        if count == 3 then
+            assert(draws == 0, draws)
+            return true
+        end
+    end,
+
+    -- Showing the client draws it again, before the frame is mapped
+    function(count)
+        local c = client.get()[1]
+        if count == 1 then
+            c:connect_signal("property::banned", function()
+                if not c.banned then
+                    draws_on_unban = draws
+                end
+            end)
+            c.screen.tags[2]:view_only()
+            return
+        end
+        if draws_on_unban then
+            assert(draws_on_unban > 0, draws_on_unban)
+            return true
+        end
+    end,
+})
+
+-- vim: filetype=lua:expandtab:shiftwidth=4:tabstop=8:softtabstop=4:textwidth=80
@@ -0,0 +1,48 @@
+-- Test that the unpacked geometry getters agree with the table ones
+
+local runner = require("_runner")
+local test_client = require("_client")
+local wibox = require("wibox")
+
+local function check(geo, x, y, width, height)
+    assert(geo.x == x, geo.x .. " ~= " .. tostring(x))
+    assert(geo.y == y, geo.y .. " ~= " .. tostring(y))
+    assert(geo.width == width, geo.width .. " ~= " .. tostring(width))
+    assert(geo.height == height, geo.height .. " ~= " .. tostring(height))
+end
+
+runner.run_steps({
+    function(count)
+        if count == 1 then
+            test_client()
+        end
+        if #client.get() >= 1 then
+            return true
+        end
+    end,
+
+    function()
+        local c = client.get()[1]
+        c.floating = true
+        c:geometry { x = 10, y = 20, width = 100, height = 200 }
+        check(c:geometry(), c:unpacked_geometry())
+
+        for s in screen do
+            check(s.geometry, s:unpacked_geometry())
+            check(s.workarea, s:unpacked_workarea())
+        end
+
+        local w = wibox { x = 5, y = 6, width = 70, height = 80, visible = true }
+        check(w.drawin:geometry(), w.drawin:unpacked_geometry())
+        check(w:geometry(), w:unpacked_geometry())
+        check(w.drawin.drawable:geometry(), w.drawin.drawable:unpacked_geometry())
+
+        local coords = mouse.coords()
+        local x, y = mouse.unpacked_coords()
+        assert(coords.x == x and coords.y == y)
+
+        return true
+    end,
+})
+
+-- vim: filetype=lua:expandtab:shiftwidth=4:tabstop=8:softtabstop=4:textwidth=80
@@ -282,18 +282,34 @@ xkb_reload_keymap(void)
     /* Free and then allocate the key symbols */
     xcb_key_symbols_free(globalconf.keysyms);
     globalconf.keysyms = xcb_key_symbols_alloc(globalconf.connection);
+    key_set_keymap_changed();
+
+    /* Keymap notifications tend to come in bursts, regrab once for all of
+     * them in xkb_refresh() */
+    globalconf.need_key_regrab = true;
+}
+
+/** Regrab the key bindings on all windows if the keymap changed since the
+ * last refresh. Only the grabs whose keycodes actually moved are sent.
+ */
+void
+xkb_refresh(void)
+{
+    if(!globalconf.need_key_regrab)
+        return;
+    globalconf.need_key_regrab = false;
 
     /* Regrab key bindings on the root window */
     xcb_screen_t *s = globalconf.screen;
-    xwindow_grabkeys(s->root, &globalconf.keys);
+    xwindow_grabkeys(s->root, globalconf.keys);
 
     /* Regrab key bindings on clients */
     foreach(_c, globalconf.clients)
     {
         client_t *c = *_c;
-        xwindow_grabkeys(c->window, &c->keys);
+        xwindow_grabkeys(c->window, c->keys);
         if (c->nofocus_window)
-            xwindow_grabkeys(c->nofocus_window, &c->keys);
+            xwindow_grabkeys(c->nofocus_window, c->keys);
     }
 }
 
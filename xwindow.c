@@ -22,7 +22,10 @@
 #include "xwindow.h"
 #include "common/atoms.h"
 #include "objects/button.h"
+#include "luaa.h"
+#include "common/xutil.h"
 
+#include <math.h>
 #include <xcb/xcb.h>
 #include <xcb/shape.h>
 #include <cairo-xcb.h>
@@ -99,56 +102,242 @@ xwindow_configure(xcb_window_t win, area_t geometry, int border)
                    XCB_EVENT_MASK_STRUCTURE_NOTIFY, (char *) &ce);
 }
 
+/** A passive grab, packed as detail << 16 | modifiers */
+typedef uint32_t xwindow_grab_t;
+DO_ARRAY(xwindow_grab_t, xwindow_grab, DO_NOTHING)
+
+/** The passive grabs currently installed on a window */
+typedef struct
+{
+    xcb_window_t window;
+    xwindow_grab_array_t keys;
+    xwindow_grab_array_t buttons;
+} xwindow_grabs_t;
+
+static int
+xwindow_grabs_cmp(const void *a, const void *b)
+{
+    const xwindow_grabs_t *x = a, *y = b;
+    return x->window > y->window ? 1 : (x->window < y->window ? -1 : 0);
+}
+
+static void
+xwindow_grabs_wipe(xwindow_grabs_t *grabs)
+{
+    xwindow_grab_array_wipe(&grabs->keys);
+    xwindow_grab_array_wipe(&grabs->buttons);
+}
+
+DO_BARRAY(xwindow_grabs_t, xwindow_grabs, xwindow_grabs_wipe, xwindow_grabs_cmp)
+
+/** Installed grabs of all windows we grabbed something on */
+static xwindow_grabs_array_t installed_grabs;
+
+static int
+xwindow_grab_cmp(const void *a, const void *b)
+{
+    const xwindow_grab_t *x = a, *y = b;
+    return *x > *y ? 1 : (*x < *y ? -1 : 0);
+}
+
+/** Sort a grab list and drop the duplicates.
+ * \param grabs The grab list.
+ */
+static void
+xwindow_grab_array_normalize(xwindow_grab_array_t *grabs)
+{
+    int len = 0;
+
+    if(grabs->len == 0)
+        return;
+
+    qsort(grabs->tab, grabs->len, sizeof(xwindow_grab_t), xwindow_grab_cmp);
+    for(int i = 1; i < grabs->len; i++)
+        if(grabs->tab[i] != grabs->tab[len])
+            grabs->tab[++len] = grabs->tab[i];
+    grabs->len = len + 1;
+}
+
+/** Find the installed grabs of a window.
+ * \param win The window.
+ * \param create Create an empty entry if there is none yet.
+ * \return The installed grabs, or NULL.
+ */
+static xwindow_grabs_t *
+xwindow_grabs_get(xcb_window_t win, bool create)
+{
+    xwindow_grabs_t key = { .window = win };
+    xwindow_grabs_t *found = xwindow_grabs_array_lookup(&installed_grabs, &key);
+
+    if(!found && create)
+    {
+        xwindow_grabs_array_insert(&installed_grabs, key);
+        found = xwindow_grabs_array_lookup(&installed_grabs, &key);
+    }
+    return found;
+}
+
+typedef void (*xwindow_grab_func_t)(xcb_window_t, xwindow_grab_t);
+
+/** Apply the difference between the installed and the wanted grabs.
+ * Ungrabbing a combination also cuts into the overlapping grabs installed
+ * with AnyModifier or on any detail, so the kept grabs sharing the detail of
+ * a removed one are installed again afterwards.
+ * \param win The window.
+ * \param installed The installed grabs, replaced by the wanted ones.
+ * \param wanted The normalized wanted grabs, taken over.
+ * \param ungrab The function removing a grab.
+ * \param grab The function installing a grab.
+ */
+static void
+xwindow_grabs_apply(xcb_window_t win, xwindow_grab_array_t *installed,
+                    xwindow_grab_array_t *wanted,
+                    xwindow_grab_func_t ungrab, xwindow_grab_func_t grab)
+{
+    /* Details hit by an ungrab, detail 0 standing for any */
+    uint32_t touched[256 / 32] = { 0 };
+    bool removed = false;
+    int i, j;
+
+    /* Both lists are sorted, so walk them in parallel */
+    for(i = 0, j = 0; i < installed->len; i++)
+    {
+        xwindow_grab_t old = installed->tab[i];
+        uint8_t detail = old >> 16;
+        while(j < wanted->len && wanted->tab[j] < old)
+            j++;
+        if(j < wanted->len && wanted->tab[j] == old)
+            continue;
+        ungrab(win, old);
+        touched[detail / 32] |= 1u << (detail % 32);
+        removed = true;
+    }
+
+    for(i = 0, j = 0; j < wanted->len; j++)
+    {
+        xwindow_grab_t new = wanted->tab[j];
+        uint8_t detail = new >> 16;
+        while(i < installed->len && installed->tab[i] < new)
+            i++;
+        if(i >= installed->len || installed->tab[i] != new
+           || (touched[0] & 1u)
+           || (touched[detail / 32] & (1u << (detail % 32)))
+           || (detail == 0 && removed))
+            grab(win, new);
+    }
+
+    xwindow_grab_array_wipe(installed);
+    *installed = *wanted;
+    xwindow_grab_array_init(wanted);
+}
+
+static void
+xwindow_button_ungrab(xcb_window_t win, xwindow_grab_t g)
+{
+    xcb_ungrab_button(globalconf.connection, g >> 16, win, g & 0xffff);
+}
+
+static void
+xwindow_button_grab(xcb_window_t win, xwindow_grab_t g)
+{
+    xcb_grab_button(globalconf.connection, false, win, BUTTONMASK,
+                    XCB_GRAB_MODE_SYNC, XCB_GRAB_MODE_ASYNC, XCB_NONE, XCB_NONE,
+                    g >> 16, g & 0xffff);
+}
+
+static void
+xwindow_key_ungrab(xcb_window_t win, xwindow_grab_t g)
+{
+    xcb_ungrab_key(globalconf.connection, g >> 16, win, g & 0xffff);
+}
+
+static void
+xwindow_key_grab(xcb_window_t win, xwindow_grab_t g)
+{
+    xcb_grab_key(globalconf.connection, true, win,
+                 g & 0xffff, g >> 16, XCB_GRAB_MODE_ASYNC, XCB_GRAB_MODE_ASYNC);
+}
+
 /** Grab or ungrab buttons on a window.
+ * Only the grabs that changed since the last call for this window are sent.
  * \param win The window.
  * \param buttons The buttons to grab.
  */
 void
 xwindow_buttons_grab(xcb_window_t win, button_array_t *buttons)
 {
+    xwindow_grab_array_t wanted;
+    xwindow_grabs_t *grabs;
+
     if(win == XCB_NONE)
         return;
 
-    /* Ungrab everything first */
-    xcb_ungrab_button(globalconf.connection, XCB_BUTTON_INDEX_ANY, win, XCB_BUTTON_MASK_ANY);
+    grabs = xwindow_grabs_get(win, false);
+    if(!grabs)
+    {
+        /* First time we see this window: start from a clean slate */
+        xcb_ungrab_button(globalconf.connection, XCB_BUTTON_INDEX_ANY, win, XCB_BUTTON_MASK_ANY);
+        grabs = xwindow_grabs_get(win, true);
+    }
 
+    xwindow_grab_array_init(&wanted);
     foreach(b, *buttons)
-        xcb_grab_button(globalconf.connection, false, win, BUTTONMASK,
-                        XCB_GRAB_MODE_SYNC, XCB_GRAB_MODE_ASYNC, XCB_NONE, XCB_NONE,
-                        (*b)->button, (*b)->modifiers);
+        xwindow_grab_array_append(&wanted, (uint32_t) (*b)->button << 16 | (*b)->modifiers);
+    xwindow_grab_array_normalize(&wanted);
+
+    xwindow_grabs_apply(win, &grabs->buttons, &wanted,
+                        xwindow_button_ungrab, xwindow_button_grab);
 }
 
-/** Grab key on a window.
+/** Grab keys on a window.
+ * The keycodes to grab are resolved once per key set and keymap, and only the
+ * grabs that changed since the last call for this window are sent.
  * \param win The window.
- * \param k The key.
+ * \param keys The key set, may be NULL.
  */
-static void
-xwindow_grabkey(xcb_window_t win, keyb_t *k)
+void
+xwindow_grabkeys(xcb_window_t win, key_set_t *keys)
 {
-    if(k->keycode)
-        xcb_grab_key(globalconf.connection, true, win,
-                     k->modifiers, k->keycode, XCB_GRAB_MODE_ASYNC, XCB_GRAB_MODE_ASYNC);
-    else if(k->keysym)
+    key_grab_array_t *key_grabs = key_set_get_grabs(keys);
+    xwindow_grab_array_t wanted;
+    xwindow_grabs_t *grabs;
+
+    if(win == XCB_NONE)
+        return;
+
+    grabs = xwindow_grabs_get(win, false);
+    if(!grabs)
     {
-        xcb_keycode_t *keycodes = xcb_key_symbols_get_keycode(globalconf.keysyms, k->keysym);
-        if(keycodes)
-        {
-            for(xcb_keycode_t *kc = keycodes; *kc; kc++)
-                xcb_grab_key(globalconf.connection, true, win,
-                             k->modifiers, *kc, XCB_GRAB_MODE_ASYNC, XCB_GRAB_MODE_ASYNC);
-            p_delete(&keycodes);
-        }
+        /* First time we see this window: start from a clean slate */
+        xcb_ungrab_key(globalconf.connection, XCB_GRAB_ANY, win, XCB_BUTTON_MASK_ANY);
+        grabs = xwindow_grabs_get(win, true);
     }
+
+    xwindow_grab_array_init(&wanted);
+    if(key_grabs)
+        foreach(grab, *key_grabs)
+            xwindow_grab_array_append(&wanted, (uint32_t) grab->keycode << 16 | grab->modifiers);
+    xwindow_grab_array_normalize(&wanted);
+
+    xwindow_grabs_apply(win, &grabs->keys, &wanted,
+                        xwindow_key_ungrab, xwindow_key_grab);
 }
 
+/** Forget the grabs installed on a window, e.g.\ because it is destroyed or
+ * no longer managed. The next grab on it starts from scratch.
+ * \param win The window.
+ */
 void
-xwindow_grabkeys(xcb_window_t win, key_array_t *keys)
+xwindow_grabs_forget(xcb_window_t win)
 {
-    /* Ungrab everything first */
-    xcb_ungrab_key(globalconf.connection, XCB_GRAB_ANY, win, XCB_BUTTON_MASK_ANY);
+    xwindow_grabs_t key = { .window = win };
+    xwindow_grabs_t *found = xwindow_grabs_array_lookup(&installed_grabs, &key);
 
-    foreach(k, *keys)
-        xwindow_grabkey(win, *k);
+    if(found)
+    {
+        xwindow_grabs_wipe(found);
+        xwindow_grabs_array_take(&installed_grabs, found - installed_grabs.tab);
+    }
 }
 
 /** Send a request for a window's opacity.
@@ -375,6 +564,124 @@ xwindow_shape_pixmap(int width, int height, cairo_surface_t *surf)
     return pixmap;
 }
 
+/** Above this number of rectangles, shapes are sent as a bitmap */
+#define XWINDOW_SHAPE_MAX_RECTANGLES 4096
+
+/** Append the rectangles covering a row of a shape.
+ * A row which is identical to the previous one extends its rectangles
+ * instead, so that the result is YX-banded.
+ * \param rects The rectangles so far.
+ * \param count The number of rectangles so far.
+ * \param band The number of rectangles in the last band.
+ * \param runs The runs of the row, as pairs of start and end x.
+ * \param nruns The number of runs.
+ * \param y The row.
+ */
+static void
+xwindow_shape_add_row(xcb_rectangle_t *rects, int *count, int *band,
+                      const int *runs, int nruns, int y)
+{
+    if (nruns > 0 && nruns == *band && *count > 0
+        && rects[*count - 1].y + rects[*count - 1].height == y)
+    {
+        xcb_rectangle_t *last = &rects[*count - nruns];
+        bool same = true;
+        for (int i = 0; i < nruns && same; i++)
+            same = last[i].x == runs[2 * i] && last[i].width == runs[2 * i + 1] - runs[2 * i];
+        if (same)
+        {
+            for (int i = 0; i < nruns; i++)
+                last[i].height++;
+            return;
+        }
+    }
+
+    for (int i = 0; i < nruns; i++)
+        rects[(*count)++] = (xcb_rectangle_t) {
+            .x = runs[2 * i],
+            .y = y,
+            .width = runs[2 * i + 1] - runs[2 * i],
+            .height = 1
+        };
+    *band = nruns;
+}
+
+/** Turn an A1 image surface into a list of rectangles.
+ * \param surf The surface.
+ * \param width The width of the shape.
+ * \param height The height of the shape.
+ * \param count On return, the number of rectangles.
+ * \return The rectangles, or NULL if the surface is not an A1 image or
+ * needs too many rectangles.
+ */
+static xcb_rectangle_t *
+xwindow_shape_rectangles_from_surface(cairo_surface_t *surf, int width, int height, int *count)
+{
+    if (cairo_surface_get_type(surf) != CAIRO_SURFACE_TYPE_IMAGE
+        || cairo_image_surface_get_format(surf) != CAIRO_FORMAT_A1)
+        return NULL;
+
+    cairo_surface_flush(surf);
+    const unsigned char *data = cairo_image_surface_get_data(surf);
+    int stride = cairo_image_surface_get_stride(surf);
+    width = MIN(width, cairo_image_surface_get_width(surf));
+    height = MIN(height, cairo_image_surface_get_height(surf));
+    if (!data || width <= 0 || height <= 0)
+    {
+        *count = 0;
+        return p_new(xcb_rectangle_t, 1);
+    }
+
+    xcb_rectangle_t *rects = p_new(xcb_rectangle_t, XWINDOW_SHAPE_MAX_RECTANGLES);
+    int *runs = p_new(int, width + 1);
+    int band = 0;
+    *count = 0;
+
+    for (int y = 0; y < height; y++)
+    {
+        const uint32_t *row = (const uint32_t *) (data + y * stride);
+        int nruns = 0;
+        bool inside = false;
+        for (int x = 0; x < width; x++)
+        {
+            /* A1 pixels are packed in native endian 32 bit words */
+#if __BYTE_ORDER__ == __ORDER_BIG_ENDIAN__
+            bool set = (row[x / 32] >> (31 - x % 32)) & 1;
+#else
+            bool set = (row[x / 32] >> (x % 32)) & 1;
+#endif
+            if (set != inside)
+            {
+                runs[nruns++] = x;
+                inside = set;
+            }
+        }
+        if (inside)
+            runs[nruns++] = width;
+        nruns /= 2;
+
+        if (*count + nruns > XWINDOW_SHAPE_MAX_RECTANGLES)
+        {
+            p_delete(&runs);
+            p_delete(&rects);
+            return NULL;
+        }
+        xwindow_shape_add_row(rects, count, &band, runs, nruns, y);
+    }
+
+    p_delete(&runs);
+    return rects;
+}
+
+/** Send a list of rectangles as one of a window's shapes */
+static void
+xwindow_shape_set_rectangles(xcb_window_t win, enum xcb_shape_sk_t kind,
+                             int x, int y, const xcb_rectangle_t *rects, int count)
+{
+    xcb_shape_rectangles(globalconf.connection, XCB_SHAPE_SO_SET, kind,
+                         XCB_CLIP_ORDERING_YX_BANDED, win, x, y, count, rects);
+}
+
 /** Set one of a window's shapes */
 void
 xwindow_set_shape(xcb_window_t win, int width, int height, enum xcb_shape_sk_t kind, cairo_surface_t *surf, int offset)
@@ -384,6 +691,20 @@ xwindow_set_shape(xcb_window_t win, int width, int height, enum xcb_shape_sk_t k
     if (kind == XCB_SHAPE_SK_INPUT && !globalconf.have_input_shape)
         return;
 
+    /* Simple shapes are cheaper to send as rectangles than as a bitmap, which
+     * has to be uploaded to the X server first */
+    if (surf && width > 0 && height > 0)
+    {
+        int count;
+        xcb_rectangle_t *rects = xwindow_shape_rectangles_from_surface(surf, width, height, &count);
+        if (rects)
+        {
+            xwindow_shape_set_rectangles(win, kind, offset, offset, rects, count);
+            p_delete(&rects);
+            return;
+        }
+    }
+
     xcb_pixmap_t pixmap = XCB_NONE;
     if (surf)
         pixmap = xwindow_shape_pixmap(width, height, surf);
@@ -394,6 +715,228 @@ xwindow_set_shape(xcb_window_t win, int width, int height, enum xcb_shape_sk_t k
         xcb_free_pixmap(globalconf.connection, pixmap);
 }
 
+/** Shapes which are computed from their parameters */
+typedef enum
+{
+    XWINDOW_SHAPE_ROUNDED_RECT,
+    XWINDOW_SHAPE_CIRCLE
+} xwindow_shape_kind_t;
+
+typedef struct
+{
+    xwindow_shape_kind_t kind;
+    int width, height;
+    /** Corner radius or circle radius */
+    double radius;
+    /** Distance by which the shape is shrunk on all sides */
+    double inset;
+    /** Which corners of a rounded rectangle are rounded */
+    bool tl, tr, br, bl;
+} xwindow_shape_t;
+
+#define XWINDOW_SHAPE_CACHE_SIZE 16
+
+/** The rectangles of the last parametric shapes, since windows with the same
+ * shape and size are common and shapes get set again on every resize */
+static struct
+{
+    xwindow_shape_t shape;
+    xcb_rectangle_t *rects;
+    int count;
+} shape_cache[XWINDOW_SHAPE_CACHE_SIZE];
+static int shape_cache_next;
+
+static bool
+xwindow_shape_equal(const xwindow_shape_t *a, const xwindow_shape_t *b)
+{
+    return a->kind == b->kind
+        && a->width == b->width && a->height == b->height
+        && a->radius == b->radius && a->inset == b->inset
+        && a->tl == b->tl && a->tr == b->tr && a->br == b->br && a->bl == b->bl;
+}
+
+/** Get the horizontal extent of a parametric shape on a row.
+ * The shapes are convex, so this is a single span.
+ * \param shape The shape.
+ * \param y The vertical position of the row's center.
+ * \param left On return, the left end of the span.
+ * \param right On return, the right end of the span.
+ * \return Whether the row intersects the shape.
+ */
+static bool
+xwindow_shape_span(const xwindow_shape_t *shape, double y, double *left, double *right)
+{
+    double w = shape->width, h = shape->height, d = shape->inset;
+
+    if (shape->kind == XWINDOW_SHAPE_CIRCLE)
+    {
+        double r = shape->radius - d, dy = y - h / 2;
+        if (r <= 0 || fabs(dy) >= r)
+            return false;
+        double dx = sqrt(r * r - dy * dy);
+        *left = w / 2 - dx;
+        *right = w / 2 + dx;
+        return true;
+    }
+
+    if (y < d || y > h - d)
+        return false;
+
+    /* Same clamping as gears.shape.rounded_rect */
+    double r = fmin(shape->radius, fmin(w / 2, h / 2));
+    r = fmax(r - d, 0);
+    double top = d + r, bottom = h - d - r;
+    double dy = y < top ? top - y : (y > bottom ? y - bottom : 0);
+    double dx = dy > 0 ? r - sqrt(fmax(r * r - dy * dy, 0)) : 0;
+    bool round_left = y < top ? shape->tl : shape->bl;
+    bool round_right = y < top ? shape->tr : shape->br;
+
+    *left = d + (round_left ? dx : 0);
+    *right = w - d - (round_right ? dx : 0);
+    return *left < *right;
+}
+
+/** Get the rectangles covering a parametric shape.
+ * Pixels are part of the shape if their center is, like when drawing the
+ * shape without antialiasing.
+ * \param shape The shape.
+ * \param count On return, the number of rectangles.
+ * \return The rectangles, owned by the cache.
+ */
+static const xcb_rectangle_t *
+xwindow_shape_rectangles(const xwindow_shape_t *shape, int *count)
+{
+    for (int i = 0; i < XWINDOW_SHAPE_CACHE_SIZE; i++)
+        if (shape_cache[i].rects && xwindow_shape_equal(&shape_cache[i].shape, shape))
+        {
+            *count = shape_cache[i].count;
+            return shape_cache[i].rects;
+        }
+
+    xcb_rectangle_t *rects = p_new(xcb_rectangle_t, MAX(shape->height, 1));
+    int n = 0, band = 0;
+    for (int y = 0; y < shape->height; y++)
+    {
+        double left, right;
+        int run[2] = { 0, 0 };
+        if (xwindow_shape_span(shape, y + 0.5, &left, &right))
+        {
+            run[0] = MAX(ceil(left - 0.5), 0);
+            run[1] = MIN(floor(right - 0.5) + 1, shape->width);
+        }
+        xwindow_shape_add_row(rects, &n, &band, run, run[0] < run[1] ? 1 : 0, y);
+    }
+
+    int slot = shape_cache_next;
+    shape_cache_next = (shape_cache_next + 1) % XWINDOW_SHAPE_CACHE_SIZE;
+    p_delete(&shape_cache[slot].rects);
+    shape_cache[slot].shape = *shape;
+    shape_cache[slot].rects = rects;
+    shape_cache[slot].count = n;
+
+    *count = n;
+    return rects;
+}
+
+/** Read a parametric shape description.
+ * \param L The Lua VM state.
+ * \param idx The index of the description table.
+ * \param shape On return, the shape.
+ * \param x The horizontal offset of the shape, may be changed.
+ * \param y The vertical offset of the shape, may be changed.
+ */
+static void
+luaA_xwindow_toshape(lua_State *L, int idx, xwindow_shape_t *shape, int *x, int *y)
+{
+    if (idx < 0)
+        idx = lua_gettop(L) + idx + 1;
+
+    lua_getfield(L, idx, "shape");
+    const char *name = luaL_optstring(L, -1, "rectangle");
+    lua_pop(L, 1);
+
+    *x = luaA_getopt_integer(L, idx, "x", *x);
+    *y = luaA_getopt_integer(L, idx, "y", *y);
+    shape->width = luaA_getopt_integer_range(L, idx, "width", shape->width, 0, MAX_X11_SIZE);
+    shape->height = luaA_getopt_integer_range(L, idx, "height", shape->height, 0, MAX_X11_SIZE);
+    shape->inset = luaA_getopt_number_range(L, idx, "inset", 0, 0, MAX_X11_SIZE);
+    shape->tl = shape->tr = shape->br = shape->bl = true;
+
+    if (A_STREQ(name, "circle"))
+    {
+        shape->kind = XWINDOW_SHAPE_CIRCLE;
+        shape->radius = luaA_getopt_number_range(L, idx, "radius",
+                                                 MIN(shape->width, shape->height) / 2.0,
+                                                 0, MAX_X11_SIZE);
+        return;
+    }
+
+    shape->kind = XWINDOW_SHAPE_ROUNDED_RECT;
+    if (A_STREQ(name, "rectangle"))
+    {
+        shape->radius = 0;
+        return;
+    }
+    if (!A_STREQ(name, "rounded_rect") && !A_STREQ(name, "partially_rounded_rect"))
+        luaL_error(L, "unknown shape: %s", name);
+
+    shape->radius = luaA_getopt_number_range(L, idx, "radius", 10, 0, MAX_X11_SIZE);
+    if (A_STREQ(name, "partially_rounded_rect"))
+    {
+        const char *corners[] = { "tl", "tr", "br", "bl" };
+        bool *flags[] = { &shape->tl, &shape->tr, &shape->br, &shape->bl };
+        for (int i = 0; i < countof(corners); i++)
+        {
+            lua_getfield(L, idx, corners[i]);
+            *flags[i] = lua_toboolean(L, -1);
+            lua_pop(L, 1);
+        }
+    }
+}
+
+/** Set one of a window's shapes from a Lua value.
+ * The value is either nil to unset the shape, a (native) cairo surface, or a
+ * table describing a parametric shape, which is turned into rectangles
+ * without drawing it. Its fields are `shape` ("rectangle", "rounded_rect",
+ * "partially_rounded_rect" or "circle"), `radius`, the `tl`, `tr`, `br` and
+ * `bl` booleans for partially rounded rectangles, `inset` to shrink the
+ * shape, and `x`, `y`, `width` and `height` to override the default
+ * geometry.
+ * \param L The Lua VM state.
+ * \param idx The index of the value.
+ * \param win The window.
+ * \param width The default width of the shape.
+ * \param height The default height of the shape.
+ * \param kind The kind of shape to set.
+ * \param offset The default position of the shape.
+ */
+void
+luaA_xwindow_set_shape(lua_State *L, int idx, xcb_window_t win, int width, int height,
+                       enum xcb_shape_sk_t kind, int offset)
+{
+    if (!lua_istable(L, idx))
+    {
+        cairo_surface_t *surf = NULL;
+        if(!lua_isnil(L, idx))
+            surf = (cairo_surface_t *)lua_touserdata(L, idx);
+        xwindow_set_shape(win, width, height, kind, surf, offset);
+        return;
+    }
+
+    xwindow_shape_t shape = { .width = width, .height = height };
+    int x = offset, y = offset;
+    luaA_xwindow_toshape(L, idx, &shape, &x, &y);
+
+    if (!globalconf.have_shape)
+        return;
+    if (kind == XCB_SHAPE_SK_INPUT && !globalconf.have_input_shape)
+        return;
+
+    int count;
+    const xcb_rectangle_t *rects = xwindow_shape_rectangles(&shape, &count);
+    xwindow_shape_set_rectangles(win, kind, x, y, rects, count);
+}
+
 /** Calculate the position change that a window needs applied.
  * \param gravity The window gravity that should be used.
  * \param change_width_before The window width difference that will be applied.
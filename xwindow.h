@@ -36,12 +36,14 @@ xcb_get_property_cookie_t xwindow_get_opacity_unchecked(xcb_window_t);
 double xwindow_get_opacity(xcb_window_t);
 double xwindow_get_opacity_from_cookie(xcb_get_property_cookie_t);
 void xwindow_set_opacity(xcb_window_t, double);
-void xwindow_grabkeys(xcb_window_t, key_array_t *);
+void xwindow_grabkeys(xcb_window_t, key_set_t *);
+void xwindow_grabs_forget(xcb_window_t);
 void xwindow_takefocus(xcb_window_t);
 void xwindow_set_cursor(xcb_window_t, xcb_cursor_t);
 void xwindow_set_border_color(xcb_window_t, color_t *);
 cairo_surface_t *xwindow_get_shape(xcb_window_t, enum xcb_shape_sk_t);
 void xwindow_set_shape(xcb_window_t, int, int, enum xcb_shape_sk_t, cairo_surface_t *, int);
+void luaA_xwindow_set_shape(lua_State *, int, xcb_window_t, int, int, enum xcb_shape_sk_t, int);
 void xwindow_translate_for_gravity(xcb_gravity_t, int16_t, int16_t, int16_t, int16_t, int16_t *, int16_t *);
 
 #define xwindow_set_name_static(win, name) \